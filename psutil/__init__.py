@@ -22,11 +22,13 @@ Works with Python versions from 2.6 to 3.4+.
 
 from __future__ import division
 
+import array
 import collections
 import contextlib
 import datetime
 import errno
 import functools
+import itertools
 import os
 import signal
 import subprocess
@@ -43,6 +45,7 @@ from ._common import deprecated_method
 from ._common import memoize
 from ._common import memoize_when_activated
 from ._common import wrap_numbers as _wrap_numbers
+from ._compat import basestring as _basestring
 from ._compat import long
 from ._compat import PY3 as _PY3
 
@@ -200,10 +203,11 @@ __all__ = [
     "SUNOS", "WINDOWS", "AIX",
 
     # classes
-    "Process", "Popen",
+    "Process", "Popen", "ProcessMonitor",
 
     # functions
     "pid_exists", "pids", "process_iter", "wait_procs",             # proc
+    "process_table", "pids_changes",
     "virtual_memory", "swap_memory",                                # memory
     "cpu_times", "cpu_percent", "cpu_times_percent", "cpu_count",   # cpu
     "cpu_stats",  # "cpu_freq",
@@ -436,12 +440,22 @@ class Process(object):
      - if you're continuously iterating over a set of Process
        instances use process_iter() which pre-emptively checks
      process identity for every yielded instance
+
+    On Linux >= 5.3, if *pidfd* is True, the instance holds a file
+    descriptor referring to the process (a pidfd): is_running() does
+    not need to read any file and signals can't be delivered to
+    another process in case the PID has been reused.
+
+    On Linux, if *watch* is True, /proc/{pid} and the stat, statm, io
+    and status files in it are kept open and re-read via pread(),
+    which is faster if the process is queried repeatedly. The files
+    held open also make is_running() exact.
     """
 
-    def __init__(self, pid=None):
-        self._init(pid)
+    def __init__(self, pid=None, pidfd=False, watch=False):
+        self._init(pid, pidfd=pidfd, watch=watch)
 
-    def _init(self, pid, _ignore_nsp=False):
+    def _init(self, pid, _ignore_nsp=False, pidfd=False, watch=False):
         if pid is None:
             pid = os.getpid()
         else:
@@ -462,10 +476,21 @@ class Process(object):
         # platform-specific modules define an _psplatform.Process
         # implementation class
         self._proc = _psplatform.Process(pid)
+        # Linux >= 5.3: hold a pidfd referring to the process, taken
+        # before reading its creation time so that both refer to the
+        # same process. Silently ignored if not supported.
+        self._pidfd = False
+        if pidfd and hasattr(self._proc, "pidfd_open"):
+            self._pidfd = self._proc.pidfd_open()
+        self._watched = False
         self._last_sys_cpu_times = None
         self._last_proc_cpu_times = None
         # cache creation time for later use in is_running() method
         try:
+            if watch and hasattr(self._proc, "watch"):
+                # Linux: keep /proc/{pid} files open; as for pidfd this
+                # is done first so that they refer to the same process.
+                self._watched = self._proc.watch()
             self.create_time()
         except AccessDenied:
             # We should never get here as AFAIK we're able to get
@@ -681,6 +706,18 @@ class Process(object):
         """
         if self._gone:
             return False
+        if self._pidfd and not self._proc.pidfd_exited():
+            # The pidfd refers to this very process, which has not
+            # terminated yet (no need to check its identity).
+            return True
+        if self._watched:
+            # Reading the files held open fails once the process is
+            # gone, even if its PID has been reused.
+            alive = self._proc.watch_alive()
+            if alive is not None:
+                if not alive:
+                    self._gone = True
+                return alive
         try:
             # Checking if PID is alive is not enough as the PID might
             # have been reused by another process: we also want to
@@ -1242,6 +1279,25 @@ class Process(object):
                 nt = _psplatform.pmmap_ext
                 return [nt(*x) for x in it]
 
+    if hasattr(_psplatform.Process, "memory_maps_iter"):
+        def memory_maps_iter(self, grouped=True, path_filter=None,
+                             perms=None):
+            """Same as memory_maps() but return a generator yielding
+            the mapped regions one at a time, reading them on the fly.
+
+            *path_filter* is a shell-style wildcard pattern (as for
+            the fnmatch module): regions whose path does not match
+            are skipped. *perms* is a string of permission characters
+            such as "rx": regions lacking any of them are skipped.
+            Filtering is done in C, while parsing.
+            """
+            if grouped:
+                nt = _psplatform.pmmap_grouped
+            else:
+                nt = _psplatform.pmmap_ext
+            it = self._proc.memory_maps_iter(grouped, path_filter, perms)
+            return (nt(*tupl) for tupl in it)
+
     def open_files(self):
         """Return files opened by process as a list of
         (path, fd) namedtuples including the absolute file name
@@ -1249,7 +1305,8 @@ class Process(object):
         """
         return self._proc.open_files()
 
-    def connections(self, kind='inet'):
+    def connections(self, kind='inet', status=None, lport=None,
+                    rport=None, laddr=None, raddr=None, details=False):
         """Return socket connections opened by process as a list of
         (fd, family, type, laddr, raddr, status) namedtuples.
         The *kind* parameter filters for connections that match the
@@ -1270,8 +1327,28 @@ class Process(object):
         | unix       | UNIX socket (both UDP and TCP protocols)           |
         | all        | the sum of all the possible families and protocols |
         +------------+----------------------------------------------------+
+
+        The other parameters, if set, further filter connections by
+        *status* (a CONN_* constant or a list of them), local / remote
+        port (*lport*, *rport*: an int or a (min, max) tuple) and
+        local / remote IP address (*laddr*, *raddr*: an "ip" or
+        "ip/prefix_len" string such as "10.0.0.0/8"), see
+        net_connections().
+        If *details* is True (Linux only) return extended namedtuples
+        including queue lengths and TCP internals, see
+        net_connections().
         """
-        return self._proc.connections(kind)
+        conn_filter = _common.ConnFilter.new(status, lport, rport, laddr,
+                                             raddr)
+        if LINUX:
+            return self._proc.connections(kind, conn_filter, details)
+        if details:
+            raise NotImplementedError("details=True is only supported on "
+                                      "Linux")
+        ret = self._proc.connections(kind)
+        if conn_filter is not None:
+            ret = _filter_connections(ret, conn_filter)
+        return ret
 
     # --- signals
 
@@ -1285,7 +1362,11 @@ class Process(object):
                     "would affect every process in the process group of the "
                     "calling process (os.getpid()) instead of PID 0")
             try:
-                os.kill(self.pid, sig)
+                if self._pidfd:
+                    # can't hit another process if the PID is reused
+                    self._proc.pidfd_send_signal(sig)
+                else:
+                    os.kill(self.pid, sig)
             except OSError as err:
                 if err.errno == errno.ESRCH:
                     if OPENBSD and pid_exists(self.pid):
@@ -1508,7 +1589,55 @@ def pid_exists(pid):
         return _psplatform.pid_exists(pid)
 
 
+# Used by pids_changes() if process events are not available: the PIDs
+# listed by the most recent calls whose token was not used yet, by
+# token (one per consumer, unless tokens are dropped).
+_PIDS_SNAPSHOTS_MAX = 32
+_pids_snapshots = collections.OrderedDict()
+_pids_snapshots_count = itertools.count(1)
+_pids_snapshots_lock = threading.Lock()
+
+
+def pids_changes(token=None):
+    """Return a (token, started, exited) namedtuple telling which
+    PIDs were created and which ones terminated since the call which
+    returned *token*. A PID may appear in both sets (a short-lived
+    process, or a PID which was reused): *exited* should be processed
+    first.
+
+    On Linux, when running as root, this is based on process events
+    notified by the kernel (proc connector) instead of listing all
+    PIDs. If events are not available PIDs are listed and compared
+    with the ones listed by the call which returned *token* (PIDs
+    reused in the meantime are not detected), and *token* can only be
+    used once. On the first call (*token* is None) or if the changes
+    since *token* are not known anymore, *started* is the set of all
+    running PIDs and *exited* is None.
+    """
+    tracker = None
+    if hasattr(_psplatform, "pids_tracker"):
+        tracker = _psplatform.pids_tracker()
+    if tracker is None:
+        current = frozenset(pids())
+        with _pids_snapshots_lock:
+            # a token can be used once
+            previous = _pids_snapshots.pop(token, None)
+            newtoken = next(_pids_snapshots_count)
+            _pids_snapshots[newtoken] = current
+            if len(_pids_snapshots) > _PIDS_SNAPSHOTS_MAX:
+                _pids_snapshots.popitem(last=False)
+        if previous is None:
+            return _common.spidschanges(newtoken, set(current), None)
+        return _common.spidschanges(
+            newtoken, set(current - previous), set(previous - current))
+    token, current, started, exited = tracker.changes(token)
+    if exited is None:
+        started = current
+    return _common.spidschanges(token, started, exited)
+
+
 _pmap = {}
+_pmap_token = None
 _lock = threading.Lock()
 
 
@@ -1545,7 +1674,40 @@ def process_iter(attrs=None, ad_value=None):
         with _lock:
             _pmap.pop(pid, None)
 
-    a = set(pids())
+    def is_running(proc):
+        if exited is not None:
+            # no exit event was received for this PID
+            return True
+        if ctimes is not None and proc.pid in ctimes and \
+                proc._create_time is not None:
+            return proc._create_time == ctimes[proc.pid]
+        return proc.is_running()
+
+    global _pmap_token
+    ctimes = None
+    exited = None
+    tracker = None
+    if hasattr(_psplatform, "pids_tracker"):
+        # Linux: if pids_changes() was used process events are being
+        # listened for; cached processes which did not exit since the
+        # last call are known to be the same (no PID reuse).
+        tracker = _psplatform.pids_tracker(create=False)
+    if tracker is not None:
+        with _lock:
+            _pmap_token, a, _, exited = tracker.changes(_pmap_token)
+        if exited is not None:
+            for pid in exited:
+                remove(pid)
+    if exited is None:
+        if hasattr(_psplatform, "create_time_map"):
+            # Linux: read PIDs and their creation time in one shot, so
+            # that we don't have to re-read /proc/{pid}/stat for every
+            # cached process in order to check whether its PID has
+            # been reused.
+            ctimes = _psplatform.create_time_map()
+            a = set(ctimes)
+        else:
+            a = set(pids())
     b = set(_pmap.keys())
     new_pids = a - b
     gone_pids = b - a
@@ -1563,7 +1725,7 @@ def process_iter(attrs=None, ad_value=None):
             else:
                 # use is_running() to check whether PID has been reused by
                 # another process in which case yield a new Process instance
-                if proc.is_running():
+                if is_running(proc):
                     if attrs is not None:
                         proc.info = proc.as_dict(
                             attrs=attrs, ad_value=ad_value)
@@ -1645,6 +1807,40 @@ def wait_procs(procs, timeout=None, callback=None):
     if timeout is not None:
         deadline = _timer() + timeout
 
+    if hasattr(_psplatform, "PidsWaiter"):
+        # Linux >= 5.3: sleep until any of the processes terminates
+        # (pidfd + poll()) rather than polling them one by one.
+        # What's left (if anything) is handled by the loop below.
+        procs_by_pid = collections.defaultdict(list)
+        for proc in alive:
+            procs_by_pid[proc.pid].append(proc)
+        try:
+            waiter = _psplatform.PidsWaiter(list(procs_by_pid))
+        except NotImplementedError:
+            waiter = None
+        try:
+            # Terminated processes which are not gone (e.g. zombies
+            # which are not our children) are not waited on anymore.
+            while alive and waiter:
+                if timeout is not None:
+                    remaining = deadline - _timer()
+                    if remaining <= 0:
+                        break
+                else:
+                    remaining = None
+                ready = waiter.wait(remaining)
+                # Reaping these won't block (nor open any fd).
+                for pid in ready | waiter.unwatched:
+                    for proc in procs_by_pid[pid]:
+                        check_gone(proc, 0)
+                    if pid in waiter.unwatched and \
+                            not set(procs_by_pid[pid]) - gone:
+                        waiter.unwatched.discard(pid)
+                alive = alive - gone
+        finally:
+            if waiter is not None:
+                waiter.close()
+
     while alive:
         if timeout is not None and timeout <= 0:
             break
@@ -1675,6 +1871,223 @@ def wait_procs(procs, timeout=None, callback=None):
     return (list(gone), list(alive))
 
 
+try:
+    array.array('q')
+except ValueError:  # Python 2
+    _TABLE_INT = 'l'
+else:
+    _TABLE_INT = 'q'
+
+# Process attributes supported by process_table() mapped to the
+# _psplatform.Process method implementing them and to the typecode
+# of the array.array(s) holding their values.
+_table_attrs = {
+    'ppid': ('ppid', _TABLE_INT),
+    'create_time': ('create_time', 'd'),
+    'nice': ('nice_get', _TABLE_INT),
+    'num_threads': ('num_threads', _TABLE_INT),
+    'num_fds': ('num_fds', _TABLE_INT),
+    'num_handles': ('num_handles', _TABLE_INT),
+    'cpu_num': ('cpu_num', _TABLE_INT),
+    'cpu_times': ('cpu_times', 'd'),
+    'memory_info': ('memory_info', _TABLE_INT),
+    'memory_full_info': ('memory_full_info', _TABLE_INT),
+    'io_counters': ('io_counters', _TABLE_INT),
+    'num_ctx_switches': ('num_ctx_switches', _TABLE_INT),
+    'uids': ('uids', _TABLE_INT),
+    'gids': ('gids', _TABLE_INT),
+}
+
+
+def process_table(attrs, pids=None):
+    """Return a snapshot of the numeric *attrs* of all running
+    processes (or of *pids* only) as a "struct of arrays": a dict
+    mapping a column name to an array.array, where the i-th item
+    of each array refers to the process whose PID is pid[i].
+
+    Attributes returning a named tuple (e.g. "memory_info") are
+    expanded into one "<attr>.<field>" column per field (e.g.
+    "memory_info.rss"). Values which cannot be retrieved because of
+    AccessDenied or ZombieProcess are set to -1 (integers) or
+    NaN (floats). Processes which disappear in the meantime are
+    not included.
+
+    Differently from process_iter() no Process instance is created
+    and no per-process dict is kept around, which makes this a lot
+    cheaper on systems with many processes. Arrays support the
+    buffer protocol so they can be wrapped by numpy with no copy:
+
+    >>> import psutil, numpy
+    >>> t = psutil.process_table(['ppid', 'memory_info'])
+    >>> rss = numpy.frombuffer(t['memory_info.rss'], dtype=numpy.int64)
+    """
+    if not isinstance(attrs, (list, tuple, set, frozenset)):
+        raise TypeError("invalid attrs type %s" % type(attrs))
+    invalid_names = set(attrs) - set(_table_attrs)
+    if invalid_names:
+        raise ValueError("invalid attr name%s %s" % (
+            "s" if len(invalid_names) > 1 else "",
+            ", ".join(map(repr, invalid_names))))
+
+    try:
+        table = collections.OrderedDict()
+    except AttributeError:
+        table = {}  # Python 2.6
+    table['pid'] = array.array(_TABLE_INT)
+    # Determine the columns each attribute expands to by querying the
+    # current process, which is always accessible.
+    me = _psplatform.Process(os.getpid())
+    getters = []
+    for name in attrs:
+        methname, typecode = _table_attrs[name]
+        meth = getattr(_psplatform.Process, methname, None)
+        if meth is None:
+            raise ValueError("%r attr is not supported on this platform"
+                             % name)
+        missing = float('nan') if typecode == 'd' else -1
+        fields = getattr(meth(me), '_fields', None)
+        if fields is None:
+            table[name] = array.array(typecode)
+            getters.append((meth, None, missing))
+        else:
+            for field in fields:
+                table["%s.%s" % (name, field)] = array.array(typecode)
+            getters.append((meth, len(fields), missing))
+    columns = list(table.values())
+
+    for pid in (pids if pids is not None else _psplatform.pids()):
+        proc = _psplatform.Process(pid)
+        row = [pid]
+        try:
+            proc.oneshot_enter()
+            try:
+                for meth, nfields, missing in getters:
+                    try:
+                        ret = meth(proc)
+                    except (AccessDenied, ZombieProcess):
+                        ret = [missing] * nfields if nfields else missing
+                    if nfields:
+                        row.extend(ret)
+                    else:
+                        row.append(ret)
+            finally:
+                proc.oneshot_exit()
+        except NoSuchProcess:
+            continue
+        for column, value in zip(columns, row):
+            column.append(value)
+    return table
+
+
+def _proc_counters_map():
+    """Return a {pid: (ident, cpu_time, read_bytes, write_bytes,
+    ctx_switches, minor_faults, major_faults)} dict for all running
+    processes, where *ident* identifies the process over time
+    (start time) and counters which can't be determined are None.
+    """
+    if hasattr(_psplatform, "proc_counters_map"):
+        return _psplatform.proc_counters_map()
+    # Generic implementation (no page faults).
+    def get(column, i):
+        if column not in t:
+            return None
+        value = t[column][i]
+        if value == -1 or value != value:  # AccessDenied (-1 or NaN)
+            return None
+        return value
+
+    attrs = [x for x in ('cpu_times', 'io_counters', 'num_ctx_switches')
+             if hasattr(_psplatform.Process, x)]
+    t = process_table(['create_time'] + attrs)
+    ret = {}
+    for i, pid in enumerate(t['pid']):
+        user = get('cpu_times.user', i)
+        system = get('cpu_times.system', i)
+        cpu_time = user + system if None not in (user, system) else None
+        vol = get('num_ctx_switches.voluntary', i)
+        invol = get('num_ctx_switches.involuntary', i)
+        ctx_switches = vol + invol if None not in (vol, invol) else None
+        ret[pid] = (t['create_time'][i], cpu_time,
+                    get('io_counters.read_bytes', i),
+                    get('io_counters.write_bytes', i),
+                    ctx_switches, None, None)
+    return ret
+
+
+class ProcessMonitor(object):
+    """Compute per-process rates for all running processes.
+
+    Every call to sample() takes a single timestamp, reads the
+    counters of all processes in one shot (on Linux by using a C
+    function which walks /proc) and returns a {pid: prates} dict
+    with the rates since the previous call:
+
+     - cpu_percent: same as Process.cpu_percent()
+     - read_bytes, write_bytes: I/O bytes/sec
+     - ctx_switches: context switches/sec (voluntary + involuntary)
+     - minor_faults, major_faults: page faults/sec (Linux only)
+
+    Rates are 0.0 on the first call and for processes which were
+    not around on the previous call (including PIDs which have been
+    reused by another process in the meantime). Rates which can't
+    be determined are None. Deltas can be obtained by multiplying
+    a rate by the *interval* attribute (seconds elapsed between the
+    last two samples).
+
+    Differently from Process.cpu_percent() no Process instance is
+    needed, which makes this suitable for monitoring all processes
+    on systems with many of them:
+
+    >>> import psutil, time
+    >>> mon = psutil.ProcessMonitor()
+    >>> mon.sample()
+    >>> time.sleep(1)
+    >>> rates = mon.sample()
+    >>> sorted(rates, key=lambda pid: rates[pid].cpu_percent)[-3:]
+    [1342, 876, 1]
+    """
+
+    def __init__(self):
+        self._last_counters = {}
+        self._last_time = None
+        self.interval = None
+
+    def __repr__(self):
+        return "%s.%s(processes=%s, interval=%r)" % (
+            self.__class__.__module__, self.__class__.__name__,
+            len(self._last_counters), self.interval)
+
+    def sample(self):
+        """Read the counters of all running processes and return
+        a {pid: prates} dict with their rates since the previous call.
+        """
+        timer = _timer()
+        counters = _proc_counters_map()
+        if self._last_time is None:
+            interval = None
+        else:
+            interval = timer - self._last_time
+        ret = {}
+        for pid, new in counters.items():
+            old = self._last_counters.get(pid)
+            rates = []
+            for i in range(1, len(new)):
+                if new[i] is None:
+                    rates.append(None)
+                elif old is None or old[0] != new[0] or not interval:
+                    rates.append(0.0)
+                elif old[i] is None:
+                    rates.append(None)
+                else:
+                    rates.append(max(new[i] - old[i], 0) / interval)
+            rates[0] = rates[0] * 100 if rates[0] is not None else None
+            ret[pid] = _common.prates(*rates)
+        self._last_counters = counters
+        self._last_time = timer
+        self.interval = interval
+        return ret
+
+
 # =====================================================================
 # --- CPU related functions
 # =====================================================================
@@ -1737,8 +2150,20 @@ except Exception:
     # Don't want to crash at import time.
     _last_cpu_times = None
 
+# On Linux per-CPU times are parsed and compared in C, in which case
+# the _last_per_cpu_times* globals hold opaque samples rather than
+# lists of namedtuples.
+_NATIVE_PER_CPU = hasattr(_psplatform, "per_cpu_times_raw")
+
+
+def _per_cpu_sample():
+    if _NATIVE_PER_CPU:
+        return _psplatform.per_cpu_times_raw()
+    return cpu_times(percpu=True)
+
+
 try:
-    _last_per_cpu_times = cpu_times(percpu=True)
+    _last_per_cpu_times = _per_cpu_sample()
 except Exception:
     # Don't want to crash at import time.
     _last_per_cpu_times = None
@@ -1872,7 +2297,7 @@ def cpu_percent(interval=None, percpu=False):
     else:
         ret = []
         if blocking:
-            tot1 = cpu_times(percpu=True)
+            tot1 = _per_cpu_sample()
             time.sleep(interval)
         else:
             tot1 = _last_per_cpu_times
@@ -1880,8 +2305,10 @@ def cpu_percent(interval=None, percpu=False):
                 # Something bad happened at import time. We'll
                 # get a meaningful result on the next call. See:
                 # https://github.com/giampaolo/psutil/pull/715
-                tot1 = cpu_times(percpu=True)
-        _last_per_cpu_times = cpu_times(percpu=True)
+                tot1 = _per_cpu_sample()
+        _last_per_cpu_times = _per_cpu_sample()
+        if _NATIVE_PER_CPU:
+            return _psplatform.per_cpu_percent(tot1, _last_per_cpu_times)
         for t1, t2 in zip(tot1, _last_per_cpu_times):
             ret.append(calculate(t1, t2))
         return ret
@@ -1948,7 +2375,7 @@ def cpu_times_percent(interval=None, percpu=False):
     else:
         ret = []
         if blocking:
-            tot1 = cpu_times(percpu=True)
+            tot1 = _per_cpu_sample()
             time.sleep(interval)
         else:
             tot1 = _last_per_cpu_times_2
@@ -1956,8 +2383,11 @@ def cpu_times_percent(interval=None, percpu=False):
                 # Something bad happened at import time. We'll
                 # get a meaningful result on the next call. See:
                 # https://github.com/giampaolo/psutil/pull/715
-                tot1 = cpu_times(percpu=True)
-        _last_per_cpu_times_2 = cpu_times(percpu=True)
+                tot1 = _per_cpu_sample()
+        _last_per_cpu_times_2 = _per_cpu_sample()
+        if _NATIVE_PER_CPU:
+            return _psplatform.per_cpu_times_percent(
+                tot1, _last_per_cpu_times_2)
         for t1, t2 in zip(tot1, _last_per_cpu_times_2):
             ret.append(calculate(t1, t2))
         return ret
@@ -1970,15 +2400,28 @@ def cpu_stats():
 
 if hasattr(_psplatform, "cpu_freq"):
 
-    def cpu_freq(percpu=False):
+    def cpu_freq(percpu=False, details=False):
         """Return CPU frequency as a nameduple including current,
         min and max frequency expressed in Mhz.
 
         If *percpu* is True and the system supports per-cpu frequency
         retrieval (Linux only) a list of frequencies is returned for
         each CPU. If not a list with one element is returned.
+
+        If *details* is True (Linux only) the namedtuple includes 3
+        more fields, which are None if not available:
+
+         - governor: the cpufreq scaling governor (e.g. "powersave").
+         - cpuinfo_min, cpuinfo_max: the hardware frequency limits,
+           while min and max are the ones set via the governor.
         """
-        ret = _psplatform.cpu_freq()
+        if LINUX:
+            ret = _psplatform.cpu_freq(details)
+        elif details:
+            raise NotImplementedError(
+                "details=True is only supported on Linux")
+        else:
+            ret = _psplatform.cpu_freq()
         if percpu:
             return ret
         else:
@@ -2008,11 +2451,52 @@ if hasattr(_psplatform, "cpu_freq"):
                     min_ = mins / num_cpus
                     max_ = maxs / num_cpus
 
+                if details:
+                    governors = set([x.governor for x in ret])
+                    governor = governors.pop() if len(governors) == 1 \
+                        else None
+                    cpuinfo_min = cpuinfo_max = None
+                    if None not in [x.cpuinfo_min for x in ret]:
+                        cpuinfo_min = sum(
+                            [x.cpuinfo_min for x in ret]) / num_cpus
+                    if None not in [x.cpuinfo_max for x in ret]:
+                        cpuinfo_max = sum(
+                            [x.cpuinfo_max for x in ret]) / num_cpus
+                    return _psplatform.scpufreqdetails(
+                        current, min_, max_, governor, cpuinfo_min,
+                        cpuinfo_max)
                 return _common.scpufreq(current, min_, max_)
 
     __all__.append("cpu_freq")
 
 
+if hasattr(_psplatform, "cpu_topology"):
+
+    def cpu_topology():
+        """Return the topology of every logical CPU as a list of
+        namedtuples, sorted by CPU number, including:
+
+         - cpu: the logical CPU number.
+         - package: the physical package (socket) ID.
+         - die: the die ID within the package.
+         - core: the core ID within the package / die.
+         - siblings: the logical CPUs sharing the same core (SMT).
+         - node: the NUMA node.
+         - caches: a tuple of (level, type, id, size, shared_cpus)
+           namedtuples, size being expressed in bytes.
+
+        Fields which are not available are set to None.
+        The topology is read once and then cached;
+        "cpu_topology.cache_clear()" can be used to read it again
+        (e.g. after CPUs have been hotplugged).
+        """
+        return list(_psplatform.cpu_topology())
+
+    cpu_topology.cache_clear = _psplatform.cpu_topology.cache_clear
+
+    __all__.append("cpu_topology")
+
+
 # =====================================================================
 # --- system memory related functions
 # =====================================================================
@@ -2175,7 +2659,7 @@ disk_io_counters.cache_clear.__doc__ = "Clears nowrap argument cache"
 # =====================================================================
 
 
-def net_io_counters(pernic=False, nowrap=True):
+def net_io_counters(pernic=False, nowrap=True, netns_pid=None):
     """Return network I/O statistics as a namedtuple including
     the following fields:
 
@@ -2189,6 +2673,9 @@ def net_io_counters(pernic=False, nowrap=True):
      - dropout:      total number of outgoing packets which were dropped
                      (always 0 on macOS and BSD)
 
+    On Linux also multicast, fifoin, fifoout, framein, carrierout,
+    collisions, compressedin and compressedout are returned.
+
     If *pernic* is True return the same information for every
     network interface installed on the system as a dictionary
     with network interface names as the keys and the namedtuple
@@ -2197,29 +2684,50 @@ def net_io_counters(pernic=False, nowrap=True):
     If *nowrap* is True it detects and adjust the numbers which overflow
     and wrap (restart from 0) and add "old value" to "new value" so that
     the returned numbers will always be increasing or remain the same,
-    but never decrease.
+    but never decrease (64-bit Linux counters never wrap).
     "disk_io_counters.cache_clear()" can be used to invalidate the
     cache.
+
+    If *netns_pid* is set (Linux only) return the NICs of the network
+    namespace the process with that PID lives in.
     """
-    rawdict = _psplatform.net_io_counters()
+    if LINUX:
+        rawdict = _psplatform.net_io_counters(netns_pid)
+    elif netns_pid is not None:
+        raise NotImplementedError("netns_pid is only supported on Linux")
+    else:
+        rawdict = _psplatform.net_io_counters()
     if not rawdict:
         return {} if pernic else None
-    if nowrap:
-        rawdict = _wrap_numbers(rawdict, 'psutil.net_io_counters')
+    # 64-bit counters never wrap.
+    if nowrap and not getattr(_psplatform, "NET_IO_COUNTERS_64BIT", False):
+        cache_name = 'psutil.net_io_counters'
+        if netns_pid is not None:
+            # NIC names of different namespaces may clash
+            cache_name += ':netns=%s' % netns_pid
+        rawdict = _wrap_numbers(rawdict, cache_name)
+    nt = getattr(_psplatform, "snetio", _common.snetio)
     if pernic:
         for nic, fields in rawdict.items():
-            rawdict[nic] = _common.snetio(*fields)
+            rawdict[nic] = nt(*fields)
         return rawdict
     else:
-        return _common.snetio(*[sum(x) for x in zip(*rawdict.values())])
+        return nt(*[sum(x) for x in zip(*rawdict.values())])
+
 
+def _net_io_counters_cache_clear():
+    """Clears nowrap argument cache"""
+    for name in list(_wrap_numbers.cache_info()[0].keys()):
+        if name == 'psutil.net_io_counters' or \
+                name.startswith('psutil.net_io_counters:'):
+            _wrap_numbers.cache_clear(name)
 
-net_io_counters.cache_clear = functools.partial(
-    _wrap_numbers.cache_clear, 'psutil.net_io_counters')
-net_io_counters.cache_clear.__doc__ = "Clears nowrap argument cache"
 
+net_io_counters.cache_clear = _net_io_counters_cache_clear
 
-def net_connections(kind='inet'):
+
+def net_connections(kind='inet', status=None, lport=None, rport=None,
+                    laddr=None, raddr=None, details=False, netns_pid=None):
     """Return system-wide socket connections as a list of
     (fd, family, type, laddr, raddr, status, pid) namedtuples.
     In case of limited privileges 'fd' and 'pid' may be set to -1
@@ -2243,12 +2751,58 @@ def net_connections(kind='inet'):
     | all        | the sum of all the possible families and protocols |
     +------------+----------------------------------------------------+
 
+    The other parameters, if set, further filter connections:
+
+     - status: a CONN_* constant or a list of them.
+     - lport, rport: local / remote port, either an int or an
+       inclusive (min, max) range.
+     - laddr, raddr: local / remote IP address as a string,
+       optionally followed by a prefix length ("10.0.0.0/8").
+       Not bound / not connected addresses are considered to be
+       "0.0.0.0" or "::" with port 0.
+
+    Port and address filters exclude UNIX sockets. On Linux they are
+    evaluated by the kernel.
+
+    If *details* is True (Linux only) the namedtuples include 6 more
+    fields, which are None if not available:
+
+     - send_queue: bytes not yet acknowledged by the remote end
+       (TCP) or not yet sent (UDP).
+     - recv_queue: bytes not yet read by the application; for TCP
+       sockets in LISTEN state the number of connections waiting to
+       be accepted.
+     - rtt: the smoothed round trip time in seconds (TCP).
+     - cwnd: the congestion window in segments (TCP).
+     - retransmits: the total number of retransmitted segments (TCP).
+     - unacked: the number of segments sent but not acknowledged yet
+       (TCP).
+
+    If *netns_pid* is set (Linux only) return the connections of the
+    network namespace the process with that PID lives in.
+
     On macOS this function requires root privileges.
     """
-    return _psplatform.net_connections(kind)
+    conn_filter = _common.ConnFilter.new(status, lport, rport, laddr, raddr)
+    if LINUX:
+        return _psplatform.net_connections(kind, conn_filter, details,
+                                           netns_pid)
+    if details:
+        raise NotImplementedError("details=True is only supported on Linux")
+    if netns_pid is not None:
+        raise NotImplementedError("netns_pid is only supported on Linux")
+    ret = _psplatform.net_connections(kind)
+    if conn_filter is not None:
+        ret = _filter_connections(ret, conn_filter)
+    return ret
+
 
+def _filter_connections(conns, conn_filter):
+    return [x for x in conns if conn_filter.match(
+        x.family, x.laddr, x.raddr, x.status)]
 
-def net_if_addrs():
+
+def net_if_addrs(nics=None, families=None):
     """Return the addresses associated to each NIC (network interface
     card) installed on the system as a dictionary whose keys are the
     NIC names and value is a list of namedtuples for each address
@@ -2265,11 +2819,24 @@ def net_if_addrs():
 
     Note: you can have more than one address of the same family
     associated with each interface.
+
+    *nics* and *families* are optional lists of NIC names and address
+    families to restrict the result to.
     """
     has_enums = sys.version_info >= (3, 4)
     if has_enums:
         import socket
-    rawlist = _psplatform.net_if_addrs()
+    if nics is not None:
+        nics = frozenset([nics] if isinstance(nics, _basestring) else nics)
+    if families is not None:
+        families = frozenset(
+            [families] if isinstance(families, int) else families)
+    if LINUX:
+        rawlist = _psplatform.net_if_addrs(nics, families)
+    else:
+        rawlist = [x for x in _psplatform.net_if_addrs()
+                   if (nics is None or x[0] in nics) and
+                   (families is None or x[1] in families)]
     rawlist.sort(key=lambda x: x[1])  # sort by family
     ret = collections.defaultdict(list)
     for name, fam, addr, mask, broadcast, ptp in rawlist:
@@ -2296,7 +2863,7 @@ def net_if_addrs():
     return dict(ret)
 
 
-def net_if_stats():
+def net_if_stats(nics=None):
     """Return information about each NIC (network interface card)
     installed on the system as a dictionary whose keys are the
     NIC names and value is a namedtuple with the following fields:
@@ -2307,8 +2874,91 @@ def net_if_stats():
      - speed: the NIC speed expressed in mega bits (MB); if it can't
               be determined (e.g. 'localhost') it will be set to 0.
      - mtu: the maximum transmission unit expressed in bytes.
+
+    *nics* is an optional list of NIC names to restrict the result to.
     """
-    return _psplatform.net_if_stats()
+    if nics is not None:
+        nics = frozenset([nics] if isinstance(nics, _basestring) else nics)
+    if LINUX:
+        return _psplatform.net_if_stats(nics)
+    ret = _psplatform.net_if_stats()
+    if nics is not None:
+        for name in list(ret.keys()):
+            if name not in nics:
+                del ret[name]
+    return ret
+
+
+# Linux
+if hasattr(_psplatform, "net_proto_counters"):
+
+    def net_proto_counters(nowrap=True):
+        """Return protocol level network statistics (IP, ICMP, TCP,
+        UDP, ...) as a dict of dicts, e.g.:
+
+        {'Tcp': {'ActiveOpens': 189, 'RetransSegs': 0, ...},
+         'Udp6': {'InDatagrams': 12, ...},
+         'sockstat': {'TCP': {'inuse': 4, 'orphan': 0, ...}, ...}}
+
+        Group and field names are the ones used by the kernel and
+        vary depending on its version. The "sockstat" group contains
+        the number of sockets in use per protocol.
+
+        If *nowrap* is True counters which overflow and wrap are
+        adjusted the same way as net_io_counters() does.
+        "net_proto_counters.cache_clear()" can be used to invalidate
+        the cache.
+        """
+        ret = _psplatform.net_proto_counters()
+        if nowrap:
+            # Key by (group, name) as some fields (e.g. "IcmpMsg")
+            # only show up after the first matching packet.
+            gauges = _psplatform.NET_PROTO_GAUGES
+            values = {}
+            for group, counters in ret.items():
+                if group == 'sockstat':
+                    continue
+                exclude = gauges.get(group, ())
+                for name, value in counters.items():
+                    if name not in exclude:
+                        values[(group, name)] = (value, )
+            values = _wrap_numbers(values, 'psutil.net_proto_counters')
+            for (group, name), (value, ) in values.items():
+                ret[group][name] = value
+        return ret
+
+    net_proto_counters.cache_clear = functools.partial(
+        _wrap_numbers.cache_clear, 'psutil.net_proto_counters')
+    net_proto_counters.cache_clear.__doc__ = "Clears nowrap argument cache"
+    __all__.append("net_proto_counters")
+
+
+# Linux
+if hasattr(_psplatform, "net_softnet_stats"):
+
+    def net_softnet_stats():
+        """Return packet processing statistics of the network stack
+        (softirq) for every CPU as a list of namedtuples with the
+        following fields:
+
+         - processed:        number of packets processed
+         - dropped:          number of packets dropped because the
+                             backlog queue was full
+         - time_squeeze:     number of times the softirq ran out of
+                             budget or time with work remaining
+         - cpu_collision:    number of times a transmit lock was
+                             contended
+         - received_rps:     number of times the CPU was woken up to
+                             process packets steered to it (RPS)
+         - flow_limit_count: number of packets dropped by flow limit
+
+        There's one entry per CPU, in the same order as
+        cpu_times(percpu=True), so it can be correlated with the
+        softirq time of each CPU.
+        """
+        return _psplatform.net_softnet_stats()
+
+    __all__.append("net_softnet_stats")
 
 
 # =====================================================================
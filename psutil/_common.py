@@ -9,6 +9,7 @@
 
 from __future__ import division
 
+import binascii
 import contextlib
 import errno
 import functools
@@ -180,6 +181,8 @@ snetio = namedtuple('snetio', ['bytes_sent', 'bytes_recv',
                                'dropin', 'dropout'])
 # psutil.users()
 suser = namedtuple('suser', ['name', 'terminal', 'host', 'started', 'pid'])
+# psutil.pids_changes()
+spidschanges = namedtuple('spidschanges', ['token', 'started', 'exited'])
 # psutil.net_connections()
 sconn = namedtuple('sconn', ['fd', 'family', 'type', 'laddr', 'raddr',
                              'status', 'pid'])
@@ -221,6 +224,10 @@ pio = namedtuple('pio', ['read_count', 'write_count',
 pionice = namedtuple('pionice', ['ioclass', 'value'])
 # psutil.Process.ctx_switches()
 pctxsw = namedtuple('pctxsw', ['voluntary', 'involuntary'])
+# psutil.ProcessMonitor.sample()
+prates = namedtuple('prates', ['cpu_percent', 'read_bytes', 'write_bytes',
+                               'ctx_switches', 'minor_faults',
+                               'major_faults'])
 # psutil.Process.connections()
 pconn = namedtuple('pconn', ['fd', 'family', 'type', 'laddr', 'raddr',
                              'status'])
@@ -259,6 +266,150 @@ if AF_UNIX is not None:
 del AF_INET, AF_UNIX, SOCK_STREAM, SOCK_DGRAM
 
 
+# ===================================================================
+# --- net_connections() / Process.connections() filters
+# ===================================================================
+
+
+_CONN_STATUSES = frozenset([
+    CONN_ESTABLISHED, CONN_SYN_SENT, CONN_SYN_RECV, CONN_FIN_WAIT1,
+    CONN_FIN_WAIT2, CONN_TIME_WAIT, CONN_CLOSE, CONN_CLOSE_WAIT,
+    CONN_LAST_ACK, CONN_LISTEN, CONN_CLOSING, CONN_NONE])
+
+
+class ConnFilter:
+    """The status, port and address filters which can be passed to
+    net_connections() and Process.connections(), validated and
+    normalized:
+
+     - status: a frozenset of CONN_* constants
+     - lport, rport: a (min, max) inclusive port range
+     - laddr, raddr: a (family, packed_ip, prefix_len) address prefix
+
+    Unset filters are None. Platforms may apply these in the kernel
+    (see _pslinux.py); match() is the reference implementation.
+    """
+
+    __slots__ = ["status", "lport", "rport", "laddr", "raddr"]
+
+    def __init__(self, status=None, lport=None, rport=None, laddr=None,
+                 raddr=None):
+        if status is not None:
+            if isinstance(status, (str, type(u""))):
+                status = [status]
+            status = frozenset(status)
+            invalid = status - _CONN_STATUSES
+            if invalid:
+                raise ValueError("invalid status %r; choose between %s" % (
+                    sorted(invalid)[0],
+                    ", ".join([repr(x) for x in sorted(_CONN_STATUSES)])))
+        self.status = status
+        self.lport = self._parse_port(lport)
+        self.rport = self._parse_port(rport)
+        self.laddr = self._parse_addr(laddr)
+        self.raddr = self._parse_addr(raddr)
+
+    @classmethod
+    def new(cls, status=None, lport=None, rport=None, laddr=None,
+            raddr=None):
+        """Return a ConnFilter instance or None if no filter is set."""
+        if status is None and lport is None and rport is None and \
+                laddr is None and raddr is None:
+            return None
+        return cls(status, lport, rport, laddr, raddr)
+
+    @staticmethod
+    def _parse_port(port):
+        """Accept an int or a (min, max) tuple."""
+        if port is None:
+            return None
+        try:
+            if isinstance(port, int):
+                lo = hi = port
+            else:
+                lo, hi = port
+                lo, hi = int(lo), int(hi)
+        except (TypeError, ValueError):
+            raise ValueError("invalid port %r; expected an int or a "
+                             "(min, max) tuple" % (port, ))
+        if not 0 <= lo <= hi <= 65535:
+            raise ValueError("invalid port %r" % (port, ))
+        return (lo, hi)
+
+    @staticmethod
+    def _parse_addr(addr):
+        """Accept an "ip" or "ip/prefix_len" string."""
+        if addr is None:
+            return None
+        ip, _, prefix = addr.partition("/")
+        for family in (socket.AF_INET, AF_INET6):
+            try:
+                packed = socket.inet_pton(family, ip)
+            except (socket.error, ValueError, TypeError):
+                continue
+            break
+        else:
+            raise ValueError("invalid IP address %r" % addr)
+        maxlen = len(packed) * 8
+        try:
+            prefix = int(prefix) if prefix else maxlen
+        except ValueError:
+            prefix = -1
+        if not 0 <= prefix <= maxlen:
+            raise ValueError("invalid prefix length in %r" % addr)
+        return (family, packed, prefix)
+
+    def match_status(self, status):
+        return self.status is None or status in self.status
+
+    def match_addrs(self, family, laddr, raddr):
+        """Match the (ip, port) local and remote addresses of an
+        AF_INET* socket (an empty tuple means "not bound / connected").
+        """
+        if family not in (socket.AF_INET, AF_INET6):
+            # UNIX sockets have neither ports nor IP addresses
+            return self.lport is None and self.rport is None and \
+                self.laddr is None and self.raddr is None
+        for addr, port_range, prefix in ((laddr, self.lport, self.laddr),
+                                         (raddr, self.rport, self.raddr)):
+            if port_range is None and prefix is None:
+                continue
+            if addr:
+                ip, port = addr[0], addr[1]
+            else:
+                ip, port = "0.0.0.0" if family == socket.AF_INET else "::", 0
+            if port_range is not None and \
+                    not port_range[0] <= port <= port_range[1]:
+                return False
+            if prefix is not None and \
+                    not self._match_prefix(family, ip, prefix):
+                return False
+        return True
+
+    def match(self, family, laddr, raddr, status):
+        return self.match_status(status) and \
+            self.match_addrs(family, laddr, raddr)
+
+    @staticmethod
+    def _match_prefix(family, ip, prefix):
+        pfamily, pbytes, plen = prefix
+        packed = socket.inet_pton(family, ip)
+        if pfamily != family:
+            # an IPv4 prefix also matches IPv4-mapped IPv6 addresses
+            # (same as the Linux kernel does)
+            v4mapped = b"\x00" * 10 + b"\xff\xff"
+            if pfamily == socket.AF_INET and packed[:12] == v4mapped:
+                packed = packed[12:]
+            else:
+                return False
+        if plen == 0:
+            return True
+        nbits = len(packed) * 8
+        ipnum = int(binascii.hexlify(packed), 16) >> (nbits - plen)
+        pnum = int(binascii.hexlify(pbytes), 16) >> (nbits - plen)
+        return ipnum == pnum
+
+
 # ===================================================================
 # --- utils
 # ===================================================================
@@ -11,11 +11,16 @@ import collections
 import errno
 import functools
 import glob
+import itertools
+import math
 import os
 import re
+import select
 import socket
 import struct
 import sys
+import threading
+import time
 import traceback
 import warnings
 from collections import defaultdict
@@ -69,6 +74,8 @@ __extra__all__ = [
 
 POWER_SUPPLY_PATH = "/sys/class/power_supply"
 HAS_SMAPS = os.path.exists('/proc/%s/smaps' % os.getpid())
+# Linux >= 4.14
+HAS_SMAPS_ROLLUP = os.path.exists('/proc/%s/smaps_rollup' % os.getpid())
 HAS_PRLIMIT = hasattr(cext, "linux_prlimit")
 HAS_PROC_IO_PRIORITY = hasattr(cext, "proc_ioprio_get")
 _DEFAULT = object()
@@ -88,6 +95,11 @@ BOOT_TIME = None  # set later
 # speedup, see: https://github.com/giampaolo/psutil/issues/708
 BIGFILE_BUFFERING = -1 if PY3 else 8192
 LITTLE_ENDIAN = sys.byteorder == 'little'
+# On Linux >= 2.6.35 NIC counters are 64 bit (on 64 bit platforms) so
+# net_io_counters() doesn't need to compensate for wrapping numbers.
+NET_IO_COUNTERS_64BIT = sys.maxsize > 2 ** 32 and tuple(
+    map(int, re.findall(r'\d+', os.uname()[2])[:3])) >= (2, 6, 35)
+_timer = getattr(time, 'monotonic', time.time)
 
 # "man iostat" states that sectors are equivalent with blocks and have
 # a size of 512 bytes. Despite this value can be queried at runtime
@@ -158,6 +170,17 @@ TCP_STATUSES = {
     "0B": _common.CONN_CLOSING
 }
 
+# TCP_NEW_SYN_RECV, reported by sock_diag as TCP_SYN_RECV
+TCP_NEW_SYN_RECV = 12
+
+# https://github.com/torvalds/linux/blob/master/include/uapi/linux/inet_diag.h
+INET_DIAG_BC_S_GE = 2
+INET_DIAG_BC_S_LE = 3
+INET_DIAG_BC_D_GE = 4
+INET_DIAG_BC_D_LE = 5
+INET_DIAG_BC_S_COND = 7
+INET_DIAG_BC_D_COND = 8
+
 # These objects get set on "import psutil" from the __init__.py
 # file, see: https://github.com/giampaolo/psutil/issues/1402
 NoSuchProcess = None
@@ -182,6 +205,25 @@ sdiskio = namedtuple(
                 'read_time', 'write_time',
                 'read_merged_count', 'write_merged_count',
                 'busy_time'])
+# psutil.net_io_counters()
+snetio = namedtuple(
+    'snetio', _common.snetio._fields + (
+        'multicast', 'fifoin', 'fifoout', 'framein', 'carrierout',
+        'collisions', 'compressedin', 'compressedout'))
+# psutil.cpu_freq(details=True)
+scpufreqdetails = namedtuple(
+    'scpufreqdetails', _common.scpufreq._fields + (
+        'governor', 'cpuinfo_min', 'cpuinfo_max'))
+# psutil.cpu_topology()
+scputopology = namedtuple(
+    'scputopology', ['cpu', 'package', 'die', 'core', 'siblings', 'node',
+                     'caches'])
+scpucache = namedtuple(
+    'scpucache', ['level', 'type', 'id', 'size', 'shared_cpus'])
+# psutil.net_softnet_stats()
+ssoftnet = namedtuple(
+    'ssoftnet', ['processed', 'dropped', 'time_squeeze', 'cpu_collision',
+                 'received_rps', 'flow_limit_count'])
 # psutil.Process().open_files()
 popenfile = namedtuple(
     'popenfile', ['path', 'fd', 'position', 'mode', 'flags'])
@@ -197,6 +239,13 @@ pmmap_grouped = namedtuple(
 # psutil.Process().memory_maps(grouped=False)
 pmmap_ext = namedtuple(
     'pmmap_ext', 'addr perms ' + ' '.join(pmmap_grouped._fields))
+# psutil.net_connections(details=True)
+sconndetails = namedtuple(
+    'sconndetails', _common.sconn._fields + (
+        'send_queue', 'recv_queue', 'rtt', 'cwnd', 'retransmits', 'unacked'))
+# psutil.Process.connections(details=True)
+pconndetails = namedtuple(
+    'pconndetails', _common.pconn._fields + sconndetails._fields[7:])
 # psutil.Process.io_counters()
 pio = namedtuple('pio', ['read_count', 'write_count',
                          'read_bytes', 'write_bytes',
@@ -274,18 +323,19 @@ def is_storage_device(name):
 
 
 @memoize
-def set_scputimes_ntuple(procfs_path):
+def set_scputimes_ntuple(procfs_path, vlen=None):
     """Set a namedtuple of variable fields depending on the CPU times
     available on this Linux kernel version which may be:
     (user, nice, system, idle, iowait, irq, softirq, [steal, [guest,
      [guest_nice]]])
-    Used by cpu_times() function.
+    Used by cpu_times() function. *vlen* is the number of values of
+    the "cpu" line of /proc/stat, if already known.
     """
     global scputimes
-    with open_binary('%s/stat' % procfs_path) as f:
-        values = f.readline().split()[1:]
+    if vlen is None:
+        with open_binary('%s/stat' % procfs_path) as f:
+            vlen = len(f.readline().split()[1:])
     fields = ['user', 'nice', 'system', 'idle', 'iowait', 'irq', 'softirq']
-    vlen = len(values)
     if vlen >= 8:
         # Linux >= 2.6.11
         fields.append('steal')
@@ -295,7 +345,9 @@ def set_scputimes_ntuple(procfs_path):
     if vlen >= 10:
         # Linux >= 3.2.0
         fields.append('guest_nice')
-    scputimes = namedtuple('scputimes', fields)
+    # creating a namedtuple is slow
+    if scputimes is None or scputimes._fields != tuple(fields):
+        scputimes = namedtuple('scputimes', fields)
 
 
 def cat(fname, fallback=_DEFAULT, binary=True):
@@ -314,6 +366,7 @@ def cat(fname, fallback=_DEFAULT, binary=True):
             raise
 
 
+scputimes = None
 try:
     set_scputimes_ntuple("/proc")
 except Exception:
@@ -576,24 +629,40 @@ def cpu_times():
     return scputimes(*fields)
 
 
+def per_cpu_times_raw():
+    """Return an opaque sample of the times of every CPU, to be passed
+    to per_cpu_percent() and per_cpu_times_percent(). /proc/stat is
+    read in one shot and parsed in C.
+    """
+    procfs_path = get_procfs_path()
+    with open_binary('%s/stat' % procfs_path) as f:
+        nfields, sample = cext.cpu_stat_parse(f.read(), CLOCK_TICKS)
+    set_scputimes_ntuple(procfs_path, nfields)
+    return sample
+
+
 def per_cpu_times():
     """Return a list of namedtuple representing the CPU times
     for every CPU available on the system.
     """
-    procfs_path = get_procfs_path()
-    set_scputimes_ntuple(procfs_path)
-    cpus = []
-    with open_binary('%s/stat' % procfs_path) as f:
-        # get rid of the first line which refers to system wide CPU stats
-        f.readline()
-        for line in f:
-            if line.startswith(b'cpu'):
-                values = line.split()
-                fields = values[1:len(scputimes._fields) + 1]
-                fields = [float(x) / CLOCK_TICKS for x in fields]
-                entry = scputimes(*fields)
-                cpus.append(entry)
-        return cpus
+    return [scputimes(*x) for x in
+            cext.cpu_stat_times(per_cpu_times_raw())]
+
+
+def per_cpu_percent(sample1, sample2):
+    """Return the utilization percentage of every CPU between two
+    per_cpu_times_raw() samples, as cpu_percent(percpu=True).
+    """
+    return cext.cpu_stat_percent(sample1, sample2)
+
+
+def per_cpu_times_percent(sample1, sample2):
+    """Return the percentage of every CPU time of every CPU between
+    two per_cpu_times_raw() samples, as
+    cpu_times_percent(percpu=True).
+    """
+    return [scputimes(*x) for x in
+            cext.cpu_stat_times_percent(sample1, sample2)]
 
 
 def cpu_count_logical():
@@ -628,10 +697,18 @@ def cpu_count_logical():
 def cpu_count_physical():
     """Return the number of physical cores in the system."""
     # Method #1
+    # Core IDs are only unique within the same package (socket) and
+    # die, so count the distinct (package, die, core) triplets.
     core_ids = set()
-    for path in glob.glob("/sys/devices/system/cpu/cpu[0-9]/topology/core_id"):
+    for path in glob.glob(
+            "/sys/devices/system/cpu/cpu[0-9]*/topology/core_id"):
+        topology = os.path.dirname(path)
         with open_binary(path) as f:
-            core_ids.add(int(f.read()))
+            core_id = int(f.read())
+        core_ids.add((
+            cat(os.path.join(topology, "physical_package_id"), fallback=None),
+            cat(os.path.join(topology, "die_id"), fallback=None),
+            core_id))
     result = len(core_ids)
     if result != 0:
         return result
@@ -681,17 +758,37 @@ def cpu_stats():
         ctx_switches, interrupts, soft_interrupts, syscalls)
 
 
-if os.path.exists("/sys/devices/system/cpu/cpufreq") or \
-        os.path.exists("/sys/devices/system/cpu/cpu0/cpufreq"):
-    def cpu_freq():
-        """Return frequency metrics for all CPUs.
-        Contrarily to other OSes, Linux updates these values in
-        real-time.
-        """
+class CpuFreqReader:
+    """Reads the frequencies and the governor of every cpufreq policy
+    (or of every CPU on old kernels). The layout is discovered once,
+    the static cpuinfo_min/max_freq files are read once, and the
+    current, min and max frequency files are kept open and re-read in
+    a single C call via pread(2), so that sampling costs no glob() nor
+    open() calls. It's discovered again if the online CPUs change.
+    """
+
+    # Only read if the scaling_* one does not exist: when running as
+    # root reading cpuinfo_cur_freq may query the hardware.
+    CUR_FILES = ("scaling_cur_freq", "cpuinfo_cur_freq")
+    FILES = ("scaling_min_freq", "scaling_max_freq")
+
+    def __init__(self, path="/sys/devices/system/cpu"):
+        self.path = path
+        self.dirs = None
+        self.paths = None
+        # None if we ran out of fds (EMFILE), in which case the files
+        # are opened on every read
+        self.fds = None
+        # [(cpuinfo_min, cpuinfo_max), ...]
+        self.limits = None
+        self.online = None
+        self.online_fd = None
+        self.lock = threading.Lock()
+
+    def discover(self):
         # scaling_* files seem preferable to cpuinfo_*, see:
         # http://unix.stackexchange.com/a/87537/168884
-        ret = []
-        ls = glob.glob("/sys/devices/system/cpu/cpufreq/policy*")
+        ls = glob.glob(os.path.join(self.path, "cpufreq", "policy*"))
         if ls:
             # Sort the list so that '10' comes after '2'. This should
             # ensure the CPU order is consistent with other CPU functions
@@ -700,27 +797,121 @@ if os.path.exists("/sys/devices/system/cpu/cpufreq") or \
             ls.sort(key=lambda x: int(os.path.basename(x)[6:]))
         else:
             # https://github.com/giampaolo/psutil/issues/981
-            ls = glob.glob("/sys/devices/system/cpu/cpu[0-9]*/cpufreq")
-            ls.sort(key=lambda x: int(re.search('[0-9]+', x).group(0)))
+            ls = glob.glob(os.path.join(self.path, "cpu[0-9]*", "cpufreq"))
+            ls.sort(key=lambda x: int(
+                os.path.basename(os.path.dirname(x))[3:]))
+        return ls
 
-        pjoin = os.path.join
-        for path in ls:
-            curr = cat(pjoin(path, "scaling_cur_freq"), fallback=None)
-            if curr is None:
+    @staticmethod
+    def read_file(path):
+        """Same as cext.sysfs_read() for a single file, used when
+        files are not kept open.
+        """
+        try:
+            value = cat(path, binary=False)
+        except (IOError, OSError):
+            return None
+        try:
+            return int(value)
+        except ValueError:
+            return value or None
+
+    def open(self):
+        if self.online_fd is None:
+            try:
+                self.online_fd = os.open(
+                    os.path.join(self.path, "online"), os.O_RDONLY)
+            except OSError:
+                self.online_fd = -1
+        if self.online_fd != -1:
+            self.online = cext.proc_pread(self.online_fd)
+        self.dirs = self.discover()
+        self.paths = []
+        self.limits = []
+        for path in self.dirs:
+            curr = os.path.join(path, self.CUR_FILES[0])
+            if not os.path.exists(curr):
                 # Likely an old RedHat, see:
                 # https://github.com/giampaolo/psutil/issues/1071
-                curr = cat(pjoin(path, "cpuinfo_cur_freq"), fallback=None)
-                if curr is None:
-                    raise NotImplementedError(
-                        "can't find current frequency file")
-            curr = int(curr) / 1000
-            max_ = int(cat(pjoin(path, "scaling_max_freq"))) / 1000
-            min_ = int(cat(pjoin(path, "scaling_min_freq"))) / 1000
-            ret.append(_common.scpufreq(curr, min_, max_))
+                curr = os.path.join(path, self.CUR_FILES[1])
+            self.paths.append(curr)
+            self.paths.extend([os.path.join(path, x) for x in self.FILES])
+            self.limits.append((
+                self.read_file(os.path.join(path, "cpuinfo_min_freq")),
+                self.read_file(os.path.join(path, "cpuinfo_max_freq"))))
+        try:
+            self.fds = cext.sysfs_open(tuple(self.paths))
+        except OSError as err:
+            if err.errno not in (errno.EMFILE, errno.ENFILE):
+                raise
+            self.fds = None
+
+    def close(self):
+        for fd in (self.fds or []) + [self.online_fd]:
+            if fd != -1:
+                os.close(fd)
+        self.dirs = self.fds = self.online_fd = None
+
+    def read(self, details=False):
+        """Return a list of scpufreq (or scpufreqdetails) namedtuples,
+        one per policy.
+        """
+        with self.lock:
+            if self.dirs is None:
+                self.open()
+            elif self.online_fd != -1 and \
+                    cext.proc_pread(self.online_fd) != self.online:
+                # CPUs were hotplugged
+                self.close()
+                self.open()
+            if self.fds is not None:
+                values = cext.sysfs_read(self.fds)
+            else:
+                values = [self.read_file(x) for x in self.paths]
+            dirs = self.dirs
+            limits = self.limits
+
+        def freq(value):
+            # in KHz; None if missing or e.g. "<unknown>"
+            if value is None or isinstance(value, basestring):
+                return None
+            return value / 1000
+
+        ret = []
+        nfiles = len(self.FILES) + 1
+        for i, path in enumerate(dirs):
+            curr, min_, max_ = values[i * nfiles:(i + 1) * nfiles]
+            curr = freq(curr)
+            if curr is None:
+                raise NotImplementedError(
+                    "can't find current frequency file")
+            nt = _common.scpufreq(curr, freq(min_), freq(max_))
+            if details:
+                governor = self.read_file(
+                    os.path.join(path, "scaling_governor"))
+                if not isinstance(governor, basestring):
+                    governor = None
+                cpuinfo_min, cpuinfo_max = limits[i]
+                nt = scpufreqdetails(
+                    *nt + (governor, freq(cpuinfo_min), freq(cpuinfo_max)))
+            ret.append(nt)
         return ret
 
+
+_cpufreq_reader = CpuFreqReader()
+
+
+if os.path.exists("/sys/devices/system/cpu/cpufreq") or \
+        os.path.exists("/sys/devices/system/cpu/cpu0/cpufreq"):
+    def cpu_freq(details=False):
+        """Return frequency metrics for all CPUs.
+        Contrarily to other OSes, Linux updates these values in
+        real-time.
+        """
+        return _cpufreq_reader.read(details)
+
 elif os.path.exists("/proc/cpuinfo"):
-    def cpu_freq():
+    def cpu_freq(details=False):
         """Alternate implementation using /proc/cpuinfo.
         min and max frequencies are not available and are set to None.
         """
@@ -729,22 +920,167 @@ elif os.path.exists("/proc/cpuinfo"):
             for line in f:
                 if line.lower().startswith(b'cpu mhz'):
                     key, value = line.split(b'\t:', 1)
-                    ret.append(_common.scpufreq(float(value), None, None))
+                    if details:
+                        nt = scpufreqdetails(
+                            float(value), None, None, None, None, None)
+                    else:
+                        nt = _common.scpufreq(float(value), None, None)
+                    ret.append(nt)
         return ret
 
 
+def parse_cpu_list(s):
+    """Parse a sysfs CPU list such as "0-3,8,10-11" into a tuple of
+    ints.
+    """
+    ret = []
+    for item in s.split(','):
+        if '-' in item:
+            lo, hi = item.split('-')
+            ret.extend(range(int(lo), int(hi) + 1))
+        elif item:
+            ret.append(int(item))
+    return tuple(ret)
+
+
+def parse_cache_size(s):
+    """Convert a sysfs cache size such as "32K" into bytes."""
+    units = {'K': 1024, 'M': 1024 ** 2, 'G': 1024 ** 3}
+    if s[-1:].upper() in units:
+        return int(s[:-1]) * units[s[-1:].upper()]
+    return int(s)
+
+
+def read_cpu_topology(path="/sys/devices/system/cpu"):
+    """Return a list of scputopology namedtuples, one per logical CPU
+    (present, not necessarily online), sorted by CPU number.
+    Fields which are not available (e.g. die on Linux < 5.2, or all
+    of them for offline CPUs) are None, or empty tuples for siblings
+    and caches.
+    """
+    def read(path, parser=int):
+        try:
+            return parser(cat(path, binary=False))
+        except (IOError, OSError, ValueError):
+            return None
+
+    def number(path, prefix):
+        # e.g. ".../cpu12" -> 12
+        return int(os.path.basename(path)[len(prefix):])
+
+    cpus = [x for x in glob.glob(os.path.join(path, "cpu[0-9]*"))
+            if os.path.basename(x)[3:].isdigit()]
+    cpus.sort(key=lambda x: number(x, "cpu"))
+    ret = []
+    for cpu in cpus:
+        topology = os.path.join(cpu, "topology")
+        # core_cpus_list is the new name of thread_siblings_list
+        # (Linux >= 5.7).
+        siblings = read(os.path.join(topology, "core_cpus_list"),
+                        parse_cpu_list)
+        if siblings is None:
+            siblings = read(os.path.join(topology, "thread_siblings_list"),
+                            parse_cpu_list)
+
+        # The CPU dir contains a "nodeN" symlink if NUMA is enabled.
+        nodes = glob.glob(os.path.join(cpu, "node[0-9]*"))
+        node = number(nodes[0], "node") if nodes else None
+
+        caches = []
+        indexes = glob.glob(os.path.join(cpu, "cache", "index[0-9]*"))
+        indexes.sort(key=lambda x: number(x, "index"))
+        for index in indexes:
+            caches.append(scpucache(
+                read(os.path.join(index, "level")),
+                read(os.path.join(index, "type"), str),
+                # "id" is not provided by all architectures (e.g. ARM)
+                read(os.path.join(index, "id")),
+                read(os.path.join(index, "size"), parse_cache_size),
+                read(os.path.join(index, "shared_cpu_list"),
+                     parse_cpu_list) or ()))
+
+        ret.append(scputopology(
+            number(cpu, "cpu"),
+            read(os.path.join(topology, "physical_package_id")),
+            read(os.path.join(topology, "die_id")),
+            read(os.path.join(topology, "core_id")),
+            siblings or (),
+            node,
+            tuple(caches)))
+    return ret
+
+
+@memoize
+def cpu_topology():
+    """Return the CPU topology, which is read once as it's not
+    supposed to change (except when CPUs are hotplugged).
+    """
+    return tuple(read_cpu_topology())
+
+
 # =====================================================================
 # --- network
 # =====================================================================
 
 
-net_if_addrs = cext_posix.net_if_addrs
+def net_if_addrs(nics=None, families=None):
+    """Return NICs addresses as a list of tuples. If *nics* or
+    *families* are not None only return the addresses of the NICs /
+    families in them.
+    """
+    try:
+        # RTM_GETLINK + RTM_GETADDR netlink dumps, filtered in C.
+        return cext.net_if_addrs(nics, families)
+    except OSError:
+        pass
+    return [x for x in cext_posix.net_if_addrs()
+            if (nics is None or x[0] in nics) and
+            (families is None or x[1] in families)]
 
 
 class _Ipv6UnsupportedError(Exception):
     pass
 
 
+def open_netns(pid):
+    """Return a fd referring to the network namespace of *pid*, to be
+    passed to the netlink based C functions which will query it from
+    a helper thread. -1 stands for our own namespace. Return None if
+    the namespace can't be opened (e.g. lack of privileges), in which
+    case /proc/[pid]/net/* files should be used instead.
+    """
+    if pid is None:
+        return -1
+    path = "%s/%s/ns/net" % (get_procfs_path(), pid)
+    try:
+        fd = os.open(path, os.O_RDONLY)
+    except EnvironmentError as err:
+        if err.errno in (errno.ENOENT, errno.ESRCH):
+            raise NoSuchProcess(pid)
+        if err.errno in (errno.EPERM, errno.EACCES):
+            return None
+        raise
+    try:
+        same = os.fstat(fd).st_ino == os.stat(
+            "%s/self/ns/net" % get_procfs_path()).st_ino
+    except EnvironmentError:
+        same = False
+    if same:
+        # no need to switch namespace
+        os.close(fd)
+        return -1
+    return fd
+
+
+def net_dir(pid):
+    """Return the /proc/net directory as seen by the network namespace
+    of *pid* (ours if None).
+    """
+    if pid is None:
+        return "%s/net" % get_procfs_path()
+    return "%s/%s/net" % (get_procfs_path(), pid)
+
+
 class Connections:
     """A wrapper on top of /proc/net/* files, retrieving per-process
     and system-wide open connections (TCP, UDP, UNIX) similarly to
@@ -801,23 +1137,15 @@ class Connections:
                     inodes[inode].append((pid, int(fd)))
         return inodes
 
-    def get_all_inodes(self):
-        inodes = {}
-        for pid in pids():
-            try:
-                inodes.update(self.get_proc_inodes(pid))
-            except OSError as err:
-                # os.listdir() is gonna raise a lot of access denied
-                # exceptions in case of unprivileged user; that's fine
-                # as we'll just end up returning a connection with PID
-                # and fd set to None anyway.
-                # Both netstat -an and lsof does the same so it's
-                # unlikely we can do any better.
-                # ENOENT just means a PID disappeared on us.
-                if err.errno not in (
-                        errno.ENOENT, errno.ESRCH, errno.EPERM, errno.EACCES):
-                    raise
-        return inodes
+    def get_all_inodes(self, wanted=None):
+        """Return a {inode: [(pid, fd), ...]} dict of the sockets opened
+        by all processes. /proc/[pid]/fd of processes we're not allowed
+        to inspect are skipped (netstat and lsof do the same): their
+        connections will have PID and fd set to None and -1.
+        If a list of "wanted" inodes is passed the others are ignored
+        and /proc is walked until all of them are found.
+        """
+        return cext.proc_socket_inodes(self._procfs_path, wanted)
 
     @staticmethod
     def decode_address(addr, family):
@@ -875,8 +1203,67 @@ class Connections:
         return _common.addr(ip, port)
 
     @staticmethod
-    def process_inet(file, family, type_, inodes, filter_pid=None):
-        """Parse /proc/net/tcp* and /proc/net/udp* files."""
+    def inet_diag_states(conn_filter):
+        """Turn the status filter into a mask of TCP states for
+        sock_diag.
+        """
+        if conn_filter is None or conn_filter.status is None:
+            return 0xffffffff
+        mask = 0
+        for num, status in TCP_STATUSES.items():
+            if status in conn_filter.status:
+                mask |= 1 << int(num, 16)
+        if _common.CONN_SYN_RECV in conn_filter.status:
+            mask |= 1 << TCP_NEW_SYN_RECV
+        return mask
+
+    @staticmethod
+    def inet_diag_bytecode(conn_filter):
+        """Compile the port and address filters into an inet_diag
+        bytecode program which the kernel runs against every socket.
+        Conditions are ANDed: every op jumps to the next one on
+        success, and past the end of the program (meaning "reject")
+        on failure.
+        """
+        if conn_filter is None:
+            return b""
+        conds = []
+        for ge, le, cond, port_range, prefix in (
+                (INET_DIAG_BC_S_GE, INET_DIAG_BC_S_LE, INET_DIAG_BC_S_COND,
+                 conn_filter.lport, conn_filter.laddr),
+                (INET_DIAG_BC_D_GE, INET_DIAG_BC_D_LE, INET_DIAG_BC_D_COND,
+                 conn_filter.rport, conn_filter.raddr)):
+            if port_range is not None:
+                lo, hi = port_range
+                # the port is stored in the "no" field of a 2nd op
+                if lo > 0:
+                    conds.append((ge, struct.pack("=BBH", 0, 0, lo)))
+                if hi < 65535:
+                    conds.append((le, struct.pack("=BBH", 0, 0, hi)))
+            if prefix is not None:
+                # struct inet_diag_hostcond followed by the address;
+                # port -1 means any port
+                fam, packed, prefix_len = prefix
+                conds.append(
+                    (cond, struct.pack("=BBxxi", fam, prefix_len, -1) +
+                     packed))
+        total = sum([4 + len(data) for _, data in conds])
+        bytecode = []
+        offset = 0
+        for code, data in conds:
+            size = 4 + len(data)
+            bytecode.append(
+                struct.pack("=BBH", code, size, total - offset + 4) + data)
+            offset += size
+        return b"".join(bytecode)
+
+    @staticmethod
+    def process_inet(file, family, type_, inodes, filter_pid=None,
+                     conn_filter=None, details=False):
+        """Parse /proc/net/tcp* and /proc/net/udp* files.
+        If details is True also yield the send / receive queue lengths
+        (other details are not available).
+        """
         if file.endswith('6') and not os.path.exists(file):
             # IPv6 not supported
             return
@@ -884,7 +1271,7 @@ class Connections:
             f.readline()  # skip the first line
             for lineno, line in enumerate(f, 1):
                 try:
-                    _, laddr, raddr, status, _, _, _, _, _, inode = \
+                    _, laddr, raddr, status, queues, _, _, _, _, inode = \
                         line.split()[:10]
                 except ValueError:
                     raise RuntimeError(
@@ -907,16 +1294,147 @@ class Connections:
                         status = TCP_STATUSES[status]
                     else:
                         status = _common.CONN_NONE
+                    if conn_filter is not None and \
+                            not conn_filter.match_status(status):
+                        continue
                     try:
                         laddr = Connections.decode_address(laddr, family)
                         raddr = Connections.decode_address(raddr, family)
                     except _Ipv6UnsupportedError:
                         continue
-                    yield (fd, family, type_, laddr, raddr, status, pid)
+                    if conn_filter is not None and \
+                            not conn_filter.match_addrs(family, laddr, raddr):
+                        continue
+                    if details:
+                        txq, rxq = queues.split(':')
+                        yield (fd, family, type_, laddr, raddr, status, pid,
+                               int(txq, 16), int(rxq, 16), None, None, None,
+                               None)
+                    else:
+                        yield (fd, family, type_, laddr, raddr, status, pid)
 
     @staticmethod
-    def process_unix(file, family, inodes, filter_pid=None):
+    def inet_diag_dump(family, type_, conn_filter=None, details=False,
+                       netns=-1):
+        """Retrieve TCP / UDP sockets via NETLINK_SOCK_DIAG, which is
+        a lot faster than parsing the /proc/net files. Sockets not
+        matching conn_filter are discarded by the kernel. *netns* is
+        the network namespace fd returned by open_netns(). Return None
+        if the kernel doesn't support it (or the namespace can't be
+        entered) so that the caller can fall back on process_inet().
+        """
+        if type_ == socket.SOCK_STREAM:
+            proto = socket.IPPROTO_TCP
+            states = Connections.inet_diag_states(conn_filter)
+            if not states:
+                return []
+        else:
+            proto = socket.IPPROTO_UDP
+            states = 0xffffffff
+            if conn_filter is not None and \
+                    not conn_filter.match_status(_common.CONN_NONE):
+                return []
+        try:
+            return cext.net_inet_diag(
+                family, proto, states,
+                Connections.inet_diag_bytecode(conn_filter), details, netns)
+        except OSError:
+            # e.g. the inet_diag / udp_diag kernel module is missing
+            return None
+
+    @staticmethod
+    def process_inet_diag(socks, family, type_, inodes, filter_pid=None):
+        """Same as process_inet() but for sockets returned by
+        inet_diag_dump().
+        """
+        ret = []
+        for item in socks:
+            inode, status, lip, lport, rip, rport = item[:6]
+            inode = str(inode)
+            if inode in inodes:
+                pid, fd = inodes[inode][0]
+            else:
+                pid, fd = None, -1
+            if filter_pid is not None and filter_pid != pid:
+                continue
+            if type_ == socket.SOCK_STREAM:
+                status = TCP_STATUSES["%02X" % status]
+            else:
+                status = _common.CONN_NONE
+            laddr = _common.addr(lip, lport) if lport else ()
+            raddr = _common.addr(rip, rport) if rport else ()
+            if len(item) == 6:
+                ret.append((fd, family, type_, laddr, raddr, status, pid))
+                continue
+            rqueue, wqueue, rtt, cwnd, retrans, unacked = item[6:]
+            if status == _common.CONN_LISTEN:
+                # wqueue is the max backlog; /proc/net/tcp* shows 0
+                wqueue = 0
+            if rtt == -1:
+                rtt = cwnd = retrans = unacked = None
+            else:
+                rtt /= 1000000.0  # usecs to secs
+            ret.append((fd, family, type_, laddr, raddr, status, pid,
+                        wqueue, rqueue, rtt, cwnd, retrans, unacked))
+        return ret
+
+    @staticmethod
+    def unix_diag_dump(conn_filter=None, netns=-1):
+        """Retrieve UNIX sockets via NETLINK_SOCK_DIAG. Return None if
+        the kernel doesn't support it so that the caller can fall back
+        on process_unix().
+        """
+        if conn_filter is not None and not conn_filter.match(
+                socket.AF_UNIX, None, None, _common.CONN_NONE):
+            return []
+        try:
+            return cext.net_unix_diag(netns)
+        except OSError:
+            # e.g. the unix_diag kernel module is missing
+            return None
+
+    @staticmethod
+    def process_unix_diag(socks, family, inodes, filter_pid=None,
+                          details=False):
+        """Same as process_unix() but for sockets returned by
+        unix_diag_dump(). Unlike /proc/net/unix this tells which socket
+        each one is connected to, so raddr is set to the path of the
+        peer socket (if it has one).
+        """
+        paths = dict([(x[0], x[3]) for x in socks])
+        ret = []
+        for inode, type_, state, path, peer, rqueue, wqueue in socks:
+            inode = str(inode)
+            if inode in inodes:
+                # With UNIX sockets we can have a single inode
+                # referencing many file descriptors.
+                pairs = inodes[inode]
+            else:
+                pairs = [(None, -1)]
+            raddr = paths.get(peer, "") if peer else ""
+            status = _common.CONN_NONE
+            for pid, fd in pairs:
+                if filter_pid is not None and filter_pid != pid:
+                    continue
+                if not details:
+                    ret.append((fd, family, type_, path, raddr, status, pid))
+                    continue
+                if TCP_STATUSES.get("%02X" % state) == _common.CONN_LISTEN:
+                    # wqueue is the max backlog
+                    wqueue = 0
+                ret.append((fd, family, type_, path, raddr, status, pid,
+                            None if wqueue == -1 else wqueue,
+                            None if rqueue == -1 else rqueue,
+                            None, None, None, None))
+        return ret
+
+    @staticmethod
+    def process_unix(file, family, inodes, filter_pid=None,
+                     conn_filter=None, details=False):
         """Parse /proc/net/unix files."""
+        if conn_filter is not None and \
+                not conn_filter.match(family, None, None, _common.CONN_NONE):
+            return
         with open_text(file, buffering=BIGFILE_BUFFERING) as f:
             f.readline()  # skip the first line
             for line in f:
@@ -945,42 +1463,92 @@ class Connections:
                         else:
                             path = ""
                         type_ = int(type_)
-                        # XXX: determining the remote endpoint of a
-                        # UNIX socket on Linux is not possible, see:
+                        # XXX: the remote endpoint of a UNIX socket
+                        # can't be determined from /proc/net/unix, see:
                         # https://serverfault.com/questions/252723/
+                        # (process_unix_diag() can)
                         raddr = ""
                         status = _common.CONN_NONE
-                        yield (fd, family, type_, path, raddr, status, pid)
+                        if details:
+                            yield (fd, family, type_, path, raddr, status,
+                                   pid, None, None, None, None, None, None)
+                        else:
+                            yield (fd, family, type_, path, raddr, status,
+                                   pid)
 
-    def retrieve(self, kind, pid=None):
+    def retrieve(self, kind, pid=None, inodes=None, conn_filter=None,
+                 details=False, netns_pid=None):
         if kind not in self.tmap:
             raise ValueError("invalid %r kind argument; choose between %s"
                              % (kind, ', '.join([repr(x) for x in self.tmap])))
         self._procfs_path = get_procfs_path()
+        netdir = net_dir(netns_pid)
         if pid is not None:
-            inodes = self.get_proc_inodes(pid)
+            if inodes is None:
+                inodes = self.get_proc_inodes(pid)
             if not inodes:
                 # no connections for this process
                 return []
-        else:
-            inodes = self.get_all_inodes()
+        # sockets retrieved via sock_diag
+        dumps = {}
+        netns = None
+        if self._procfs_path == '/proc':
+            # netlink can only see the network namespaces of this
+            # system, hence not a custom PROCFS_PATH
+            netns = open_netns(netns_pid)
+        if netns is not None:
+            try:
+                for f, family, type_ in self.tmap[kind]:
+                    if family in (socket.AF_INET, socket.AF_INET6):
+                        socks = self.inet_diag_dump(
+                            family, type_, conn_filter, details, netns)
+                    else:
+                        socks = self.unix_diag_dump(conn_filter, netns)
+                    if socks is not None:
+                        dumps[f] = socks
+            finally:
+                if netns != -1:
+                    os.close(netns)
+        if pid is None:
+            if len(dumps) == len(self.tmap[kind]):
+                # we know in advance which sockets we're interested in
+                # so we can stop walking /proc once they're all found
+                # (inode 0 == TIME_WAIT sockets, owned by nobody)
+                wanted = [x[0] for socks in dumps.values() for x in socks
+                          if x[0]]
+                inodes = self.get_all_inodes(wanted)
+            else:
+                inodes = self.get_all_inodes()
         ret = set()
         for f, family, type_ in self.tmap[kind]:
-            if family in (socket.AF_INET, socket.AF_INET6):
+            if f in dumps and family == socket.AF_UNIX:
+                ls = self.process_unix_diag(
+                    dumps[f], family, inodes, filter_pid=pid,
+                    details=details)
+            elif f in dumps:
+                ls = self.process_inet_diag(
+                    dumps[f], family, type_, inodes, filter_pid=pid)
+            elif family in (socket.AF_INET, socket.AF_INET6):
                 ls = self.process_inet(
-                    "%s/net/%s" % (self._procfs_path, f),
-                    family, type_, inodes, filter_pid=pid)
+                    "%s/%s" % (netdir, f),
+                    family, type_, inodes, filter_pid=pid,
+                    conn_filter=conn_filter, details=details)
             else:
                 ls = self.process_unix(
-                    "%s/net/%s" % (self._procfs_path, f),
-                    family, inodes, filter_pid=pid)
-            for fd, family, type_, laddr, raddr, status, bound_pid in ls:
+                    "%s/%s" % (netdir, f),
+                    family, inodes, filter_pid=pid, conn_filter=conn_filter,
+                    details=details)
+            for item in ls:
                 if pid:
-                    conn = _common.pconn(fd, family, type_, laddr, raddr,
-                                         status)
+                    # no bound_pid
+                    if details:
+                        conn = pconndetails(*(item[:6] + item[7:]))
+                    else:
+                        conn = _common.pconn(*item[:6])
+                elif details:
+                    conn = sconndetails(*item)
                 else:
-                    conn = _common.sconn(fd, family, type_, laddr, raddr,
-                                         status, bound_pid)
+                    conn = _common.sconn(*item)
                 ret.add(conn)
         return list(ret)
 
@@ -988,16 +1556,32 @@ class Connections:
 _connections = Connections()
 
 
-def net_connections(kind='inet'):
-    """Return system-wide open connections."""
-    return _connections.retrieve(kind)
+def net_connections(kind='inet', conn_filter=None, details=False,
+                    netns_pid=None):
+    """Return system-wide open connections, of the network namespace
+    of *netns_pid* if not None.
+    """
+    return _connections.retrieve(kind, conn_filter=conn_filter,
+                                 details=details, netns_pid=netns_pid)
 
 
-def net_io_counters():
+def net_io_counters(netns_pid=None):
     """Return network I/O statistics for every network interface
-    installed on the system as a dict of raw tuples.
+    installed on the system as a dict of raw tuples. If *netns_pid*
+    is not None return the NICs of the network namespace of that PID.
     """
-    with open_text("%s/net/dev" % get_procfs_path()) as f:
+    if get_procfs_path() == '/proc':
+        netns = open_netns(netns_pid)
+        if netns is not None:
+            try:
+                # One RTM_GETLINK netlink dump for all the NICs.
+                return cext.net_io_counters(netns)
+            except OSError:
+                pass
+            finally:
+                if netns != -1:
+                    os.close(netns)
+    with open_text("%s/dev" % net_dir(netns_pid)) as f:
         lines = f.readlines()
     retdict = {}
     for line in lines[2:]:
@@ -1011,43 +1595,127 @@ def net_io_counters():
          packets_recv,
          errin,
          dropin,
-         fifoin,  # unused
-         framein,  # unused
-         compressedin,  # unused
-         multicastin,  # unused
+         fifoin,
+         framein,
+         compressedin,
+         multicast,
          # out
          bytes_sent,
          packets_sent,
          errout,
          dropout,
-         fifoout,  # unused
-         collisionsout,  # unused
-         carrierout,  # unused
+         fifoout,
+         collisions,
+         carrierout,
          compressedout) = map(int, fields)
 
         retdict[name] = (bytes_sent, bytes_recv, packets_sent, packets_recv,
-                         errin, errout, dropin, dropout)
+                         errin, errout, dropin, dropout, multicast, fifoin,
+                         fifoout, framein, carrierout, collisions,
+                         compressedin, compressedout)
     return retdict
 
 
-def net_if_stats():
-    """Get NIC stats (isup, duplex, speed, mtu)."""
+def net_if_stats(nics=None):
+    """Get NIC stats (isup, duplex, speed, mtu). If *nics* is not None
+    only return the NICs whose name is in it.
+    """
     duplex_map = {cext.DUPLEX_FULL: NIC_DUPLEX_FULL,
                   cext.DUPLEX_HALF: NIC_DUPLEX_HALF,
                   cext.DUPLEX_UNKNOWN: NIC_DUPLEX_UNKNOWN}
-    names = net_io_counters().keys()
-    ret = {}
-    for name in names:
+    rawdict = None
+    if get_procfs_path() == '/proc':
         try:
-            mtu = cext_posix.net_if_mtu(name)
-            isup = cext_posix.net_if_flags(name)
-            duplex, speed = cext.net_if_duplex_speed(name)
-        except OSError as err:
-            # https://github.com/giampaolo/psutil/issues/1279
-            if err.errno != errno.ENODEV:
-                raise
-        else:
-            ret[name] = _common.snicstats(isup, duplex_map[duplex], speed, mtu)
+            # One RTM_GETLINK netlink dump for all the NICs.
+            rawdict = cext.net_if_stats(nics)
+        except OSError:
+            pass
+    if rawdict is None:
+        rawdict = {}
+        for name in net_io_counters().keys():
+            if nics is not None and name not in nics:
+                continue
+            try:
+                mtu = cext_posix.net_if_mtu(name)
+                isup = cext_posix.net_if_flags(name)
+                duplex, speed = cext.net_if_duplex_speed(name)
+            except OSError as err:
+                # https://github.com/giampaolo/psutil/issues/1279
+                if err.errno != errno.ENODEV:
+                    raise
+            else:
+                rawdict[name] = (isup, duplex, speed, mtu)
+    ret = {}
+    for name, (isup, duplex, speed, mtu) in rawdict.items():
+        ret[name] = _common.snicstats(isup, duplex_map[duplex], speed, mtu)
+    return ret
+
+
+# Fields of /proc/net/snmp which are not counters, hence are not
+# supposed to be treated as numbers which wrapped if they decrease.
+NET_PROTO_GAUGES = {
+    'Ip': ('Forwarding', 'DefaultTTL'),
+    'Tcp': ('RtoAlgorithm', 'RtoMin', 'RtoMax', 'MaxConn', 'CurrEstab'),
+}
+
+
+def net_proto_counters():
+    """Return protocol level statistics as a {group: {name: value}}
+    dict. Counters come from /proc/net/snmp, /proc/net/netstat and
+    /proc/net/snmp6, while the "sockstat" group contains the socket
+    gauges of /proc/net/sockstat{,6}, as {'TCP': {'inuse': 4, ...}}.
+    Every file is read in one shot and missing ones (e.g. snmp6 if
+    IPv6 is disabled) are skipped.
+    """
+    netdir = "%s/net" % get_procfs_path()
+    ret = {}
+    for fname in ('snmp', 'netstat'):
+        data = cat("%s/%s" % (netdir, fname), fallback=None, binary=False)
+        if data is None:
+            continue
+        # pairs of lines, e.g. "Tcp: RtoAlgorithm RtoMin ..." followed
+        # by "Tcp: 1 200 ..."
+        lines = data.split('\n')
+        for i in range(0, len(lines) - 1, 2):
+            names = lines[i].split()
+            values = lines[i + 1].split()
+            group = ret.setdefault(names[0][:-1], {})
+            group.update(zip(names[1:], map(int, values[1:])))
+
+    data = cat("%s/snmp6" % netdir, fallback=None, binary=False)
+    if data is not None:
+        for line in data.split('\n'):
+            key, value = line.split()
+            # e.g. "Ip6InReceives" -> "Ip6", "InReceives"
+            group, name = re.match(r'([A-Za-z]+6)(.+)', key).groups()
+            ret.setdefault(group, {})[name] = int(value)
+
+    sockstat = ret['sockstat'] = {}
+    for fname in ('sockstat', 'sockstat6'):
+        data = cat("%s/%s" % (netdir, fname), fallback=None, binary=False)
+        if data is None:
+            continue
+        # e.g. "TCP: inuse 4 orphan 0 tw 2 alloc 4 mem 0"
+        for line in data.split('\n'):
+            fields = line.split()
+            sockstat[fields[0][:-1]] = dict(
+                zip(fields[1::2], map(int, fields[2::2])))
+    return ret
+
+
+def net_softnet_stats():
+    """Return per-CPU packet processing statistics from
+    /proc/net/softnet_stat as a list of namedtuples. There's one
+    row per online CPU, in the same order as per_cpu_times().
+    """
+    ret = []
+    with open_binary("%s/net/softnet_stat" % get_procfs_path()) as f:
+        for line in f:
+            # hex columns; 3-7 are unused, received_rps was added in
+            # 2.6.35 and flow_limit_count in 3.11
+            values = [int(x, 16) for x in line.split()]
+            values.extend([0] * (11 - len(values)))
+            ret.append(ssoftnet(*(values[:3] + values[8:11])))
     return ret
 
 
@@ -1193,10 +1861,15 @@ def disk_partitions(all=False):
 # =====================================================================
 
 
-def sensors_temperatures():
-    """Return hardware (CPU and others) temperatures as a dict
-    including hardware name, label, current, max and critical
-    temperatures.
+class SensorReader:
+    """Reads hardware temperatures and fans speed from hwmon (or
+    thermal zones). Sensors are enumerated once and their static
+    attributes (name, label, max and critical temperatures) are
+    cached; on every sample only the *_input files are re-read via
+    pread(2), from fds kept open, in a single C call. Sensors are
+    enumerated again if a hwmon device (or thermal zone) comes or
+    goes, or if a sensor which could be read right after enumerating
+    them can't be read anymore (e.g. its driver was reloaded).
 
     Implementation notes:
     - /sys/class/hwmon looks like the most recent interface to
@@ -1206,127 +1879,224 @@ def sensors_temperatures():
     - /sys/class/thermal/thermal_zone* is another one but it's more
       difficult to parse
     """
-    ret = collections.defaultdict(list)
-    basenames = glob.glob('/sys/class/hwmon/hwmon*/temp*_*')
-    # CentOS has an intermediate /device directory:
-    # https://github.com/giampaolo/psutil/issues/971
-    # https://github.com/nicolargo/glances/issues/1060
-    basenames.extend(glob.glob('/sys/class/hwmon/hwmon*/device/temp*_*'))
-    basenames = sorted(set([x.split('_')[0] for x in basenames]))
-
-    for base in basenames:
-        try:
-            path = base + '_input'
-            current = float(cat(path)) / 1000.0
-            path = os.path.join(os.path.dirname(base), 'name')
-            unit_name = cat(path, binary=False)
-        except (IOError, OSError, ValueError) as err:
-            # A lot of things can go wrong here, so let's just skip the
-            # whole entry. Sure thing is Linux's /sys/class/hwmon really
-            # is a stinky broken mess.
-            # https://github.com/giampaolo/psutil/issues/1009
-            # https://github.com/giampaolo/psutil/issues/1101
-            # https://github.com/giampaolo/psutil/issues/1129
-            # https://github.com/giampaolo/psutil/issues/1245
-            # https://github.com/giampaolo/psutil/issues/1323
-            warnings.warn("ignoring %r for file %r" % (err, path),
-                          RuntimeWarning)
-            continue
 
-        high = cat(base + '_max', fallback=None)
-        critical = cat(base + '_crit', fallback=None)
-        label = cat(base + '_label', fallback='', binary=False)
+    def __init__(self, path="/sys/class"):
+        self.path = path
+        self.listing = None
+        # [fds, [(path, unit_name, label, high, critical), ...], failed]
+        self.temps_cache = None
+        # [fds, [(path, unit_name, label), ...], failed]
+        self.fans_cache = None
+        self.lock = threading.Lock()
 
-        if high is not None:
-            try:
-                high = float(high) / 1000.0
-            except ValueError:
-                high = None
-        if critical is not None:
+    @staticmethod
+    def _basenames(pattern):
+        # e.g. "/sys/class/hwmon/hwmon0/temp1_input" -> ".../temp1"
+        return sorted(set([
+            os.path.join(os.path.dirname(x), os.path.basename(x).split('_')[0])
+            for x in glob.glob(pattern)]))
+
+    @staticmethod
+    def _temp(value):
+        if value is not None:
             try:
-                critical = float(critical) / 1000.0
+                return float(value) / 1000.0
             except ValueError:
-                critical = None
+                return None
 
-        ret[unit_name].append((label, current, high, critical))
+    def _listing(self):
+        ret = []
+        for name in ("hwmon", "thermal"):
+            try:
+                ret.append(sorted(os.listdir(os.path.join(self.path, name))))
+            except OSError:
+                ret.append(None)
+        return ret
 
-    # Indication that no sensors were detected in /sys/class/hwmon/
-    if not basenames:
-        basenames = glob.glob('/sys/class/thermal/thermal_zone*')
-        basenames = sorted(set(basenames))
+    def _discover_temps(self):
+        ret = []
+        hwmon = os.path.join(self.path, "hwmon", "hwmon*")
+        basenames = self._basenames(os.path.join(hwmon, 'temp*_*'))
+        # CentOS has an intermediate /device directory:
+        # https://github.com/giampaolo/psutil/issues/971
+        # https://github.com/nicolargo/glances/issues/1060
+        basenames.extend(self._basenames(
+            os.path.join(hwmon, 'device', 'temp*_*')))
 
         for base in basenames:
+            path = os.path.join(os.path.dirname(base), 'name')
             try:
-                path = os.path.join(base, 'temp')
-                current = float(cat(path)) / 1000.0
+                unit_name = cat(path, binary=False)
+            except (IOError, OSError) as err:
+                warnings.warn("ignoring %r for file %r" % (err, path),
+                              RuntimeWarning)
+                continue
+            high = self._temp(cat(base + '_max', fallback=None))
+            critical = self._temp(cat(base + '_crit', fallback=None))
+            label = cat(base + '_label', fallback='', binary=False)
+            ret.append((base + '_input', unit_name, label, high, critical))
+
+        # Indication that no sensors were detected in /sys/class/hwmon/
+        if not basenames:
+            basenames = sorted(set(glob.glob(
+                os.path.join(self.path, "thermal", "thermal_zone*"))))
+            for base in basenames:
                 path = os.path.join(base, 'type')
+                try:
+                    unit_name = cat(path, binary=False)
+                except (IOError, OSError) as err:
+                    warnings.warn("ignoring %r for file %r" % (err, path),
+                                  RuntimeWarning)
+                    continue
+
+                trip_paths = glob.glob(base + '/trip_point*')
+                trip_points = set(['_'.join(
+                    os.path.basename(p).split('_')[0:3]) for p in trip_paths])
+                critical = None
+                high = None
+                for trip_point in trip_points:
+                    path = os.path.join(base, trip_point + "_type")
+                    trip_type = cat(path, fallback='', binary=False)
+                    if trip_type == 'critical':
+                        critical = self._temp(cat(
+                            os.path.join(base, trip_point + "_temp"),
+                            fallback=None))
+                    elif trip_type == 'high':
+                        high = self._temp(cat(
+                            os.path.join(base, trip_point + "_temp"),
+                            fallback=None))
+                ret.append((os.path.join(base, 'temp'), unit_name, '', high,
+                            critical))
+        return ret
+
+    def _discover_fans(self):
+        ret = []
+        hwmon = os.path.join(self.path, "hwmon", "hwmon*")
+        basenames = self._basenames(os.path.join(hwmon, 'fan*_*'))
+        if not basenames:
+            # CentOS has an intermediate /device directory:
+            # https://github.com/giampaolo/psutil/issues/971
+            basenames = self._basenames(
+                os.path.join(hwmon, 'device', 'fan*_*'))
+
+        for base in basenames:
+            path = os.path.join(os.path.dirname(base), 'name')
+            try:
                 unit_name = cat(path, binary=False)
-            except (IOError, OSError, ValueError) as err:
+            except (IOError, OSError) as err:
                 warnings.warn("ignoring %r for file %r" % (err, path),
                               RuntimeWarning)
                 continue
+            label = cat(base + '_label', fallback='', binary=False)
+            ret.append((base + '_input', unit_name, label))
+        return ret
 
-            trip_paths = glob.glob(base + '/trip_point*')
-            trip_points = set(['_'.join(
-                os.path.basename(p).split('_')[0:3]) for p in trip_paths])
-            critical = None
-            high = None
-            for trip_point in trip_points:
-                path = os.path.join(base, trip_point + "_type")
-                trip_type = cat(path, fallback='', binary=False)
-                if trip_type == 'critical':
-                    critical = cat(os.path.join(base, trip_point + "_temp"),
-                                   fallback=None)
-                elif trip_type == 'high':
-                    high = cat(os.path.join(base, trip_point + "_temp"),
-                               fallback=None)
-
-                if high is not None:
-                    try:
-                        high = float(high) / 1000.0
-                    except ValueError:
-                        high = None
-                if critical is not None:
-                    try:
-                        critical = float(critical) / 1000.0
-                    except ValueError:
-                        critical = None
+    def _open(self, sensors):
+        fds = cext.sysfs_open(tuple([x[0] for x in sensors]))
+        for fd, sensor in zip(fds, sensors):
+            if fd == -1:
+                warnings.warn("ignoring unreadable file %r" % sensor[0],
+                              RuntimeWarning)
+        # "failed" is the set of indexes of the sensors which couldn't
+        # be read right after being enumerated, set on the first read
+        return [[x for x in fds if x != -1],
+                [x for fd, x in zip(fds, sensors) if fd != -1],
+                None]
 
-            ret[unit_name].append(('', current, high, critical))
+    @staticmethod
+    def _close(cache):
+        if cache is not None:
+            for fd in cache[0]:
+                os.close(fd)
+
+    def close(self):
+        self._close(self.temps_cache)
+        self._close(self.fans_cache)
+        self.temps_cache = self.fans_cache = None
+
+    def _cache(self, kind, reset=False):
+        attr = kind + "_cache"
+        if reset:
+            self._close(getattr(self, attr))
+            setattr(self, attr, None)
+        if getattr(self, attr) is None:
+            if kind == "temps":
+                setattr(self, attr, self._open(self._discover_temps()))
+            else:
+                setattr(self, attr, self._open(self._discover_fans()))
+        return getattr(self, attr)
 
-    return dict(ret)
+    def _read(self, kind):
+        """Return the values of the temperature or fan *_input files,
+        paired with the cached attributes of their sensor.
+        """
+        with self.lock:
+            listing = self._listing()
+            if listing != self.listing:
+                self.close()
+                self.listing = listing
+            cache = self._cache(kind)
+            values = cext.sysfs_read(cache[0])
+            failed = set([i for i, x in enumerate(values) if x is None])
+            if cache[2] is not None and not failed.issubset(cache[2]):
+                # The fd of a sensor which used to work may refer to a
+                # file which is gone (e.g. the driver was reloaded and
+                # reading returns ENODEV) so enumerate sensors again.
+                # Sensors which always fail (EIO, ENODATA, ...) don't
+                # cause this.
+                cache = self._cache(kind, reset=True)
+                values = cext.sysfs_read(cache[0])
+                failed = set([i for i, x in enumerate(values) if x is None])
+            if cache[2] is None:
+                cache[2] = failed
+            sensors = cache[1]
+        ret = []
+        for value, sensor in zip(values, sensors):
+            if value is None or isinstance(value, basestring):
+                # A lot of things can go wrong here, so let's just skip
+                # the whole entry. Sure thing is Linux's
+                # /sys/class/hwmon really is a stinky broken mess.
+                # https://github.com/giampaolo/psutil/issues/1009
+                # https://github.com/giampaolo/psutil/issues/1101
+                # https://github.com/giampaolo/psutil/issues/1129
+                # https://github.com/giampaolo/psutil/issues/1245
+                # https://github.com/giampaolo/psutil/issues/1323
+                warnings.warn("ignoring unreadable file %r" % sensor[0],
+                              RuntimeWarning)
+                continue
+            ret.append((value, sensor))
+        return ret
 
+    def temperatures(self):
+        ret = collections.defaultdict(list)
+        for value, (_, unit_name, label, high, critical) in \
+                self._read("temps"):
+            ret[unit_name].append((label, value / 1000.0, high, critical))
+        return dict(ret)
 
-def sensors_fans():
-    """Return hardware fans info (for CPU and other peripherals) as a
-    dict including hardware label and current speed.
+    def fans(self):
+        ret = collections.defaultdict(list)
+        for value, (_, unit_name, label) in self._read("fans"):
+            ret[unit_name].append(_common.sfan(label, value))
+        return dict(ret)
 
-    Implementation notes:
-    - /sys/class/hwmon looks like the most recent interface to
-      retrieve this info, and this implementation relies on it
-      only (old distros will probably use something else)
-    - lm-sensors on Ubuntu 16.04 relies on /sys/class/hwmon
+
+_sensor_reader = SensorReader()
+
+
+def sensors_temperatures():
+    """Return hardware (CPU and others) temperatures as a dict
+    including hardware name, label, current, max and critical
+    temperatures.
     """
-    ret = collections.defaultdict(list)
-    basenames = glob.glob('/sys/class/hwmon/hwmon*/fan*_*')
-    if not basenames:
-        # CentOS has an intermediate /device directory:
-        # https://github.com/giampaolo/psutil/issues/971
-        basenames = glob.glob('/sys/class/hwmon/hwmon*/device/fan*_*')
+    return _sensor_reader.temperatures()
 
-    basenames = sorted(set([x.split('_')[0] for x in basenames]))
-    for base in basenames:
-        try:
-            current = int(cat(base + '_input'))
-        except (IOError, OSError) as err:
-            warnings.warn("ignoring %r" % err, RuntimeWarning)
-            continue
-        unit_name = cat(os.path.join(os.path.dirname(base), 'name'),
-                        binary=False)
-        label = cat(base + '_label', fallback='', binary=False)
-        ret[unit_name].append(_common.sfan(label, current))
 
-    return dict(ret)
+def sensors_fans():
+    """Return hardware fans info (for CPU and other peripherals) as a
+    dict including hardware label and current speed.
+    """
+    return _sensor_reader.fans()
 
 
 def sensors_battery():
@@ -1491,29 +2261,314 @@ def pid_exists(pid):
             return pid in pids()
 
 
+def proc_stat_scan():
+    """Read /proc/{pid}/stat of all running processes in one shot
+    (C implementation) and return a list of
+    (pid, ppid, status, utime, stime, starttime, rss, minflt, majflt,
+    num_threads, cpu_num) tuples. CPU times and starttime are expressed
+    in clock ticks, rss in pages.
+    """
+    return cext.proc_stat_scan(get_procfs_path())
+
+
 def ppid_map():
     """Obtain a {pid: ppid, ...} dict for all running processes in
     one shot. Used to speed up Process.children().
     """
+    return dict([(x[0], x[1]) for x in proc_stat_scan()])
+
+
+def create_time_map():
+    """Obtain a {pid: create_time, ...} dict for all running processes
+    in one shot. Used to speed up process_iter(), which would otherwise
+    re-read /proc/{pid}/stat of every cached process in order to check
+    whether its PID has been reused.
+    """
+    # Same math as Process.create_time(), so that values compare equal.
+    bt = BOOT_TIME or boot_time()
+    return dict([(x[0], (x[5] / CLOCK_TICKS) + bt)
+                 for x in proc_stat_scan()])
+
+
+def proc_counters_map():
+    """Obtain a {pid: (ident, cpu_time, read_bytes, write_bytes,
+    ctx_switches, minor_faults, major_faults), ...} dict for all running
+    processes in one shot. Used by ProcessMonitor. *ident* is the
+    process start time in clock ticks; counters which can't be
+    determined are None.
+    """
     ret = {}
     procfs_path = get_procfs_path()
-    for pid in pids():
-        try:
-            with open_binary("%s/%s/stat" % (procfs_path, pid)) as f:
-                data = f.read()
-        except EnvironmentError as err:
-            # Note: we should be able to access /stat for all processes
-            # aka it's unlikely we'll bump into EPERM, which is good.
-            if err.errno not in (errno.ENOENT, errno.ESRCH):
-                raise
+    for (pid, starttime, utime, stime, minflt, majflt, read_bytes,
+            write_bytes, vol_ctxsw, invol_ctxsw) in \
+            cext.proc_counters_scan(procfs_path):
+        if read_bytes == -1:
+            read_bytes = write_bytes = None
+        if vol_ctxsw == -1 or invol_ctxsw == -1:
+            ctx_switches = None
         else:
-            rpar = data.rfind(b')')
-            dset = data[rpar + 2:].split()
-            ppid = int(dset[1])
-            ret[pid] = ppid
+            ctx_switches = vol_ctxsw + invol_ctxsw
+        ret[pid] = (starttime, (utime + stime) / CLOCK_TICKS, read_bytes,
+                    write_bytes, ctx_switches, minflt, majflt)
     return ret
 
 
+class PidsTracker(object):
+    """Keep the set of running PIDs up to date by listening for the
+    fork / exit events notified by the kernel proc connector, so that
+    /proc does not have to be listed over and over again.
+    Requires CAP_NET_ADMIN (root), else OSError is raised on creation.
+    """
+    # Max number of events kept around in order to tell the changes
+    # since a given token.
+    LOG_SIZE = 65536
+    _generation = itertools.count(1)
+
+    def __init__(self):
+        self._fd = cext.proc_events_open()
+        self._owner = os.getpid()
+        self._lock = threading.Lock()
+        self._log = collections.deque(maxlen=self.LOG_SIZE)
+        self._seq = 0
+        self._resync()
+
+    def _resync(self):
+        # Done after subscribing (so that no event occurring in the
+        # meantime is missed) and after losing events because the
+        # socket buffer was full. Tokens issued so far are invalidated.
+        self._pids = set(pids())
+        self._log.clear()
+        self._gen = next(self._generation)
+
+    def _update(self):
+        while True:
+            try:
+                events = cext.proc_events_read(self._fd)
+            except OSError as err:
+                if err.errno != errno.ENOBUFS:
+                    raise
+                self._resync()
+            else:
+                break
+        for event, pid in events:
+            if event == cext.PROC_EVENT_FORK:
+                self._pids.add(pid)
+            else:
+                self._pids.discard(pid)
+            self._log.append((event, pid))
+            self._seq += 1
+
+    def close(self):
+        os.close(self._fd)
+
+    def changes(self, token):
+        """Return a (token, pids, started, exited) tuple where *pids*
+        is the set of running PIDs and *started* and *exited* are the
+        sets of PIDs which were created / terminated since the call
+        which returned *token*. A PID can appear in both (short-lived
+        processes, reused PIDs): exited ones should be processed first.
+        If the events since *token* are not available anymore
+        *started* and *exited* are None.
+        """
+        with self._lock:
+            self._update()
+            newtoken = (self._gen, self._seq)
+            current = set(self._pids)
+            if token is None or token[0] != self._gen or \
+                    self._seq - token[1] > len(self._log):
+                return (newtoken, current, None, None)
+            started = set()
+            exited = set()
+            skip = len(self._log) - (self._seq - token[1])
+            for event, pid in itertools.islice(self._log, skip, None):
+                if event == cext.PROC_EVENT_FORK:
+                    started.add(pid)
+                else:
+                    exited.add(pid)
+            return (newtoken, current, started, exited)
+
+
+_pids_tracker = None
+
+
+def pids_tracker(create=True):
+    """Return the PidsTracker singleton, creating it first if *create*
+    is True. Return None if the proc connector can't be used (not
+    root, kernel without CONFIG_PROC_EVENTS, PROCFS_PATH pointing to
+    a different /proc).
+    """
+    global _pids_tracker
+    if get_procfs_path() != '/proc':
+        return None
+    tracker = _pids_tracker
+    if tracker and tracker._owner != os.getpid():
+        # We've been forked: the socket is shared with the parent.
+        tracker.close()
+        tracker = _pids_tracker = None
+    if tracker is None and create:
+        try:
+            tracker = _pids_tracker = PidsTracker()
+        except OSError:
+            # don't try again
+            tracker = _pids_tracker = False
+    return tracker or None
+
+
+def _poll_pidfds(fds, timeout=None):
+    """poll() a list of pidfds and return the readable ones (the
+    processes which terminated). *timeout* is in seconds.
+    """
+    poller = select.poll()
+    for fd in fds:
+        poller.register(fd, select.POLLIN)
+    return _poll(poller, timeout)
+
+
+def _poll(poller, timeout=None):
+    """Same as poller.poll() but *timeout* is in seconds, EINTR is
+    retried and only the ready fds are returned.
+    """
+    if timeout is not None:
+        stop_at = _timer() + timeout
+    while True:
+        if timeout is None:
+            ms = None
+        else:
+            # round up so that we don't wake up too early and spin
+            ms = max(0, int(math.ceil((stop_at - _timer()) * 1000)))
+        try:
+            return [fd for fd, _ in poller.poll(ms)]
+        except (select.error, OSError) as err:
+            # Python < 3.5 does not retry on EINTR
+            if err.args[0] != errno.EINTR:
+                raise
+
+
+def wait_pid(pid, timeout=None, proc_name=None, pidfd=None):
+    """Same as _psposix.wait_pid() but, if pidfds are supported (Linux
+    >= 5.3), sleep in poll() until the process terminates instead of
+    polling with increasing sleeps. If *pidfd* is passed it's used
+    instead of opening a new one.
+    """
+    if timeout == 0:
+        # nothing to sleep on: just reap it if it's a zombie child
+        return _psposix.wait_pid(pid, timeout, proc_name)
+    if pidfd is None:
+        try:
+            fd = cext.proc_pidfd_open(pid)
+        except OSError:
+            # ENOSYS (Linux < 5.3), ESRCH (no such process), EPERM
+            # (seccomp)
+            return _psposix.wait_pid(pid, timeout, proc_name)
+    else:
+        fd = pidfd
+    if timeout is not None:
+        stop_at = _timer() + timeout
+    try:
+        if not _poll_pidfds([fd], timeout):
+            raise TimeoutExpired(timeout, pid=pid, name=proc_name)
+    finally:
+        if pidfd is None:
+            os.close(fd)
+    if timeout is not None:
+        timeout = max(stop_at - _timer(), 0)
+    # The process terminated. If it's a child of ours reap it and
+    # return its exit code.
+    try:
+        retpid, status = os.waitpid(pid, os.WNOHANG)
+    except OSError as err:
+        if err.errno != errno.ECHILD:
+            raise
+        # Not our child: it may still be a zombie waiting for its
+        # parent to reap it, in which case we keep waiting until it's
+        # gone, as _psposix.wait_pid() does.
+        return _psposix.wait_pid(pid, timeout, proc_name)
+    if retpid == 0:
+        # should never happen
+        return _psposix.wait_pid(pid, timeout, proc_name)
+    return _psposix.convert_exit_status(status)
+
+
+class PidsWaiter:
+    """Wait for many PIDs to terminate by using poll() on their pidfds
+    all at once (Linux >= 5.3). Every pidfd is opened once and stays
+    registered in the same poll object until its process terminates,
+    so that waiting for N processes costs N pidfd_open() calls
+    overall. Raise NotImplementedError if pidfds are not supported.
+    """
+
+    def __init__(self, pids):
+        self.poller = select.poll()
+        # {pidfd: pid}
+        self.fds = {}
+        # PIDs which terminated (or did not exist) not yet returned
+        self.ready = set()
+        # PIDs which can't be waited on because we ran out of file
+        # descriptors; the caller has to poll these
+        self.unwatched = set()
+        try:
+            self._watch(pids)
+        except NotImplementedError:
+            self.close()
+            raise
+
+    def __len__(self):
+        # the number of PIDs still waited on
+        return len(self.fds) + len(self.ready) + len(self.unwatched)
+
+    def _watch(self, pids):
+        for pid in pids:
+            try:
+                fd = cext.proc_pidfd_open(pid)
+            except OSError as err:
+                if err.errno == errno.ESRCH:
+                    self.unwatched.discard(pid)
+                    self.ready.add(pid)
+                elif err.errno in (errno.EMFILE, errno.ENFILE):
+                    self.unwatched.add(pid)
+                elif err.errno in (errno.ENOSYS, errno.EPERM):
+                    # Linux < 5.3 or seccomp
+                    raise NotImplementedError("pidfd_open() not supported")
+                else:
+                    raise
+            else:
+                self.unwatched.discard(pid)
+                self.fds[fd] = pid
+                self.poller.register(fd, select.POLLIN)
+
+    def _unwatch(self, fd):
+        self.poller.unregister(fd)
+        os.close(fd)
+        return self.fds.pop(fd)
+
+    def wait(self, timeout=None):
+        """Wait until at least one of the PIDs terminates and return
+        the set of the ones which terminated (or did not exist) since
+        the last call; these are not waited on anymore. If there are
+        unwatched PIDs wait at most 40 ms, same as _psposix.wait_pid()
+        max sleep.
+        """
+        if self.ready:
+            timeout = 0
+        elif self.unwatched:
+            timeout = 0.04 if timeout is None else min(timeout, 0.04)
+        if self.fds:
+            for fd in _poll(self.poller, timeout):
+                self.ready.add(self._unwatch(fd))
+        elif timeout:
+            time.sleep(timeout)
+        ret = self.ready
+        self.ready = set()
+        if ret and self.unwatched:
+            # some fds were freed
+            self._watch(list(self.unwatched))
+        return ret
+
+    def close(self):
+        for fd in list(self.fds):
+            self._unwatch(fd)
+
+
 def wrap_exceptions(fun):
     """Decorator which translates bare OSError and IOError exceptions
     into NoSuchProcess and AccessDenied.
@@ -1542,13 +2597,96 @@ def wrap_exceptions(fun):
 class Process(object):
     """Linux process implementation."""
 
-    __slots__ = ["pid", "_name", "_ppid", "_procfs_path", "_cache"]
+    __slots__ = ["pid", "_name", "_ppid", "_procfs_path", "_cache", "_pidfd",
+                 "_dirfd", "_watched"]
+
+    # files kept open by watch()
+    _WATCHED_FILES = ("stat", "statm", "io", "status")
 
     def __init__(self, pid):
         self.pid = pid
         self._name = None
         self._ppid = None
         self._procfs_path = get_procfs_path()
+        self._pidfd = None
+        self._dirfd = None
+        self._watched = None
+
+    def __del__(self):
+        if self._pidfd is not None:
+            os.close(self._pidfd)
+            self._pidfd = None
+        if self._dirfd is not None:
+            for fd in self._watched.values():
+                os.close(fd)
+            os.close(self._dirfd)
+            self._dirfd = self._watched = None
+
+    def pidfd_open(self):
+        """Hold a pidfd referring to this process (Linux >= 5.3), which
+        pins its identity: it keeps referring to the same process even
+        if the PID gets reused. Return False if a pidfd can't be
+        obtained (not supported, no such process, too many open files).
+        """
+        if self._pidfd is None:
+            try:
+                self._pidfd = cext.proc_pidfd_open(self.pid)
+            except OSError:
+                return False
+        return True
+
+    def pidfd_exited(self):
+        """Return True if the process referred to by the pidfd
+        terminated (it may still be a zombie). Never blocks.
+        """
+        return bool(_poll_pidfds([self._pidfd], 0))
+
+    def pidfd_send_signal(self, sig):
+        # Raw OSError is raised, as for os.kill().
+        cext.proc_pidfd_send_signal(self._pidfd, sig)
+
+    @wrap_exceptions
+    def watch(self):
+        """Keep /proc/{pid} (O_PATH) and the stat, statm, io and status
+        files open, so that they're re-read via pread() instead of
+        being looked up, opened and closed on every call. The fds
+        refer to this very process: once it's gone reading them
+        fails with ESRCH (NoSuchProcess) even if the PID was reused.
+        """
+        if self._dirfd is None:
+            dirfd, fds = cext.proc_watch_open(
+                "%s/%s" % (self._procfs_path, self.pid), self._WATCHED_FILES)
+            self._watched = dict(
+                [(k, v) for k, v in zip(self._WATCHED_FILES, fds) if v != -1])
+            self._dirfd = dirfd
+        return True
+
+    def watch_alive(self):
+        """Return whether the process watched via watch() was not
+        reaped yet (it may be a zombie), or None if unknown.
+        """
+        fd = self._watched.get("stat")
+        if fd is None:
+            return None
+        try:
+            cext.proc_pread(fd)
+        except OSError as err:
+            if err.errno == errno.ESRCH:
+                return False
+            raise
+        return True
+
+    def _read_file(self, name):
+        """Return the content of /proc/{pid}/{name}, read from the fd
+        kept open by watch(), if any.
+        """
+        if self._watched:
+            fd = self._watched.get(name)
+            if fd is not None:
+                return cext.proc_pread(fd)
+        with open_binary("%s/%s/%s" % (self._procfs_path, self.pid,
+                                       name)) as f:
+            return f.read()
 
     def _assert_alive(self):
         """Raise NSP if the process disappeared on us."""
@@ -1567,8 +2705,7 @@ class Process(object):
         The return value is cached in case oneshot() ctx manager is
         in use.
         """
-        with open_binary("%s/%s/stat" % (self._procfs_path, self.pid)) as f:
-            data = f.read()
+        data = self._read_file("stat")
         # Process name is between parentheses. It can contain spaces and
         # other parentheses. This is taken into account by looking for
         # the first occurrence of "(" and the last occurence of ")".
@@ -1597,8 +2734,7 @@ class Process(object):
         The return value is cached in case oneshot() ctx manager is
         in use.
         """
-        with open_binary("%s/%s/status" % (self._procfs_path, self.pid)) as f:
-            return f.read()
+        return self._read_file("status")
 
     @wrap_exceptions
     @memoize_when_activated
@@ -1607,15 +2743,81 @@ class Process(object):
                          buffering=BIGFILE_BUFFERING) as f:
             return f.read().strip()
 
+    @wrap_exceptions
+    @memoize_when_activated
+    def _read_smaps_rollup_file(self):
+        return self._read_file("smaps_rollup")
+
+    @wrap_exceptions
+    @memoize_when_activated
+    def _read_statm_file(self):
+        return self._read_file("statm")
+
+    @wrap_exceptions
+    @memoize_when_activated
+    def _read_io_file(self):
+        return self._read_file("io")
+
+    @wrap_exceptions
+    @memoize_when_activated
+    def _read_cmdline_file(self):
+        with open_text("%s/%s/cmdline" % (self._procfs_path, self.pid)) as f:
+            return f.read()
+
+    @wrap_exceptions
+    @memoize_when_activated
+    def _list_fds(self):
+        """List /proc/{pid}/fd directory."""
+        return os.listdir("%s/%s/fd" % (self._procfs_path, self.pid))
+
+    @wrap_exceptions
+    @memoize_when_activated
+    def _read_fd_links(self):
+        """Resolve the /proc/{pid}/fd links and return a
+        ([(fd, path), ...], hit_enoent) tuple, where hit_enoent
+        tells whether some fd was closed in the meantime.
+        Shared by open_files() and connections().
+        """
+        links = []
+        hit_enoent = False
+        for fd in self._list_fds():
+            try:
+                path = readlink("%s/%s/fd/%s" % (
+                    self._procfs_path, self.pid, fd))
+            except OSError as err:
+                # ENOENT == file which is gone in the meantime
+                if err.errno in (errno.ENOENT, errno.ESRCH):
+                    hit_enoent = True
+                    continue
+                elif err.errno == errno.EINVAL:
+                    # not a link
+                    continue
+                else:
+                    raise
+            links.append((int(fd), path))
+        return (links, hit_enoent)
+
     def oneshot_enter(self):
         self._parse_stat_file.cache_activate(self)
         self._read_status_file.cache_activate(self)
         self._read_smaps_file.cache_activate(self)
+        self._read_smaps_rollup_file.cache_activate(self)
+        self._read_statm_file.cache_activate(self)
+        self._read_io_file.cache_activate(self)
+        self._read_cmdline_file.cache_activate(self)
+        self._list_fds.cache_activate(self)
+        self._read_fd_links.cache_activate(self)
 
     def oneshot_exit(self):
         self._parse_stat_file.cache_deactivate(self)
         self._read_status_file.cache_deactivate(self)
         self._read_smaps_file.cache_deactivate(self)
+        self._read_smaps_rollup_file.cache_deactivate(self)
+        self._read_statm_file.cache_deactivate(self)
+        self._read_io_file.cache_deactivate(self)
+        self._read_cmdline_file.cache_deactivate(self)
+        self._list_fds.cache_deactivate(self)
+        self._read_fd_links.cache_deactivate(self)
 
     @wrap_exceptions
     def name(self):
@@ -1646,8 +2848,7 @@ class Process(object):
 
     @wrap_exceptions
     def cmdline(self):
-        with open_text("%s/%s/cmdline" % (self._procfs_path, self.pid)) as f:
-            data = f.read()
+        data = self._read_cmdline_file()
         if not data:
             # may happen in case of zombie process
             return []
@@ -1684,18 +2885,17 @@ class Process(object):
         def io_counters(self):
             fname = "%s/%s/io" % (self._procfs_path, self.pid)
             fields = {}
-            with open_binary(fname) as f:
-                for line in f:
-                    # https://github.com/giampaolo/psutil/issues/1004
-                    line = line.strip()
-                    if line:
-                        try:
-                            name, value = line.split(b': ')
-                        except ValueError:
-                            # https://github.com/giampaolo/psutil/issues/1004
-                            continue
-                        else:
-                            fields[name] = int(value)
+            for line in self._read_io_file().splitlines():
+                # https://github.com/giampaolo/psutil/issues/1004
+                line = line.strip()
+                if line:
+                    try:
+                        name, value = line.split(b': ')
+                    except ValueError:
+                        # https://github.com/giampaolo/psutil/issues/1004
+                        continue
+                    else:
+                        fields[name] = int(value)
             if not fields:
                 raise RuntimeError("%s file was empty" % fname)
             try:
@@ -1727,7 +2927,7 @@ class Process(object):
 
     @wrap_exceptions
     def wait(self, timeout=None):
-        return _psposix.wait_pid(self.pid, timeout, self._name)
+        return wait_pid(self.pid, timeout, self._name, self._pidfd)
 
     @wrap_exceptions
     def create_time(self):
@@ -1753,9 +2953,8 @@ class Process(object):
         # | data   | data + stack                        | drs  | DATA |
         # | dirty  | dirty pages (unused in Linux 2.6)   | dt   |      |
         #  ============================================================
-        with open_binary("%s/%s/statm" % (self._procfs_path, self.pid)) as f:
-            vms, rss, shared, text, lib, data, dirty = \
-                [int(x) * PAGESIZE for x in f.readline().split()[:7]]
+        vms, rss, shared, text, lib, data, dirty = \
+            [int(x) * PAGESIZE for x in self._read_statm_file().split()[:7]]
         return pmem(rss, vms, shared, text, lib, data, dirty)
 
     # /proc/pid/smaps does not exist on kernels < 2.6.14 or if
@@ -1770,11 +2969,6 @@ class Process(object):
                 _pss_re=re.compile(br"\nPss\:\s+(\d+)"),
                 _swap_re=re.compile(br"\nSwap\:\s+(\d+)")):
             basic_mem = self.memory_info()
-            # Note: using 3 regexes is faster than reading the file
-            # line by line.
-            # XXX: on Python 3 the 2 regexes are 30% slower than on
-            # Python 2 though. Figure out why.
-            #
             # You might be tempted to calculate USS by subtracting
             # the "shared" value from the "resident" value in
             # /proc/<pid>/statm. But at least on Linux, statm's "shared"
@@ -1782,12 +2976,21 @@ class Process(object):
             # little to do with whether the pages are actually shared.
             # /proc/self/smaps on the other hand appears to give us the
             # correct information.
-            smaps_data = self._read_smaps_file()
-            # Note: smaps file can be empty for certain processes.
-            # The code below will not crash though and will result to 0.
-            uss = sum(map(int, _private_re.findall(smaps_data))) * 1024
-            pss = sum(map(int, _pss_re.findall(smaps_data))) * 1024
-            swap = sum(map(int, _swap_re.findall(smaps_data))) * 1024
+            if HAS_SMAPS_ROLLUP:
+                # Same fields as smaps, already summed up by the kernel
+                # for all the mappings, so it's just a few lines.
+                smaps_data = self._read_smaps_rollup_file()
+                # Note: the file can be empty for certain processes.
+                # The code below will not crash though and will result
+                # to 0.
+                uss = sum(map(int, _private_re.findall(smaps_data))) * 1024
+                pss = sum(map(int, _pss_re.findall(smaps_data))) * 1024
+                swap = sum(map(int, _swap_re.findall(smaps_data))) * 1024
+            else:
+                # smaps can be huge (one block per mapping): it's
+                # parsed in C on the fly rather than read in memory.
+                uss, pss, swap = cext.proc_smaps_totals(
+                    "%s/%s/smaps" % (self._procfs_path, self.pid))
             return pfullmem(*basic_mem + (uss, pss, swap))
 
     else:
@@ -1863,6 +3066,46 @@ class Process(object):
                 ))
             return ls
 
+        @wrap_exceptions
+        def _open_smaps_file(self):
+            return open_binary("%s/%s/smaps" % (self._procfs_path, self.pid),
+                               buffering=0)
+
+        @wrap_exceptions
+        def _read_smaps_chunk(self, f, size=65536):
+            return f.read(size)
+
+        def memory_maps_iter(self, grouped, path_filter=None, perms=None):
+            """Same as memory_maps() but /proc/{PID}/smaps is read and
+            parsed (in C) one chunk at a time. Mappings filtered out
+            are never turned into Python objects. If *grouped* is True
+            the mappings are summed up by path and (path, rss, ...)
+            tuples are yielded at the end.
+            The file is opened immediately so that NoSuchProcess and
+            AccessDenied are raised by this call rather than on
+            iteration.
+            """
+            f = self._open_smaps_file()
+            return self._iter_smaps_file(f, grouped, path_filter, perms)
+
+        def _iter_smaps_file(self, f, grouped, path_filter, perms):
+            groups = {} if grouped else None
+            with f:
+                data = b""
+                while True:
+                    chunk = self._read_smaps_chunk(f)
+                    data += chunk
+                    consumed, ls = cext.proc_smaps_parse(
+                        data, not chunk, path_filter, perms, groups)
+                    for tupl in ls:
+                        yield tupl
+                    if not chunk:
+                        break
+                    data = data[consumed:]
+            if grouped:
+                for path, nums in groups.items():
+                    yield (path, ) + tuple(nums)
+
     @wrap_exceptions
     def cwd(self):
         try:
@@ -2057,60 +3300,50 @@ class Process(object):
     @wrap_exceptions
     def open_files(self):
         retlist = []
-        files = os.listdir("%s/%s/fd" % (self._procfs_path, self.pid))
-        hit_enoent = False
-        for fd in files:
-            file = "%s/%s/fd/%s" % (self._procfs_path, self.pid, fd)
-            try:
-                path = readlink(file)
-            except OSError as err:
-                # ENOENT == file which is gone in the meantime
-                if err.errno in (errno.ENOENT, errno.ESRCH):
-                    hit_enoent = True
-                    continue
-                elif err.errno == errno.EINVAL:
-                    # not a link
-                    continue
-                else:
-                    raise
-            else:
-                # If path is not an absolute there's no way to tell
-                # whether it's a regular file or not, so we skip it.
-                # A regular file is always supposed to be have an
-                # absolute path though.
-                if path.startswith('/') and isfile_strict(path):
-                    # Get file position and flags.
-                    file = "%s/%s/fdinfo/%s" % (
-                        self._procfs_path, self.pid, fd)
-                    try:
-                        with open_binary(file) as f:
-                            pos = int(f.readline().split()[1])
-                            flags = int(f.readline().split()[1], 8)
-                    except IOError as err:
-                        if err.errno == errno.ENOENT:
-                            # fd gone in the meantime; process may
-                            # still be alive
-                            hit_enoent = True
-                        else:
-                            raise
+        links, hit_enoent = self._read_fd_links()
+        for fd, path in links:
+            # If path is not an absolute there's no way to tell
+            # whether it's a regular file or not, so we skip it.
+            # A regular file is always supposed to be have an
+            # absolute path though.
+            if path.startswith('/') and isfile_strict(path):
+                # Get file position and flags.
+                file = "%s/%s/fdinfo/%s" % (
+                    self._procfs_path, self.pid, fd)
+                try:
+                    with open_binary(file) as f:
+                        pos = int(f.readline().split()[1])
+                        flags = int(f.readline().split()[1], 8)
+                except IOError as err:
+                    if err.errno == errno.ENOENT:
+                        # fd gone in the meantime; process may
+                        # still be alive
+                        hit_enoent = True
                     else:
-                        mode = file_flags_to_mode(flags)
-                        ntuple = popenfile(
-                            path, int(fd), int(pos), mode, flags)
-                        retlist.append(ntuple)
+                        raise
+                else:
+                    mode = file_flags_to_mode(flags)
+                    ntuple = popenfile(path, fd, int(pos), mode, flags)
+                    retlist.append(ntuple)
         if hit_enoent:
             self._assert_alive()
         return retlist
 
     @wrap_exceptions
-    def connections(self, kind='inet'):
-        ret = _connections.retrieve(kind, self.pid)
+    def connections(self, kind='inet', conn_filter=None, details=False):
+        inodes = defaultdict(list)
+        for fd, path in self._read_fd_links()[0]:
+            if path.startswith('socket:['):
+                # the process is using a socket
+                inodes[path[8:][:-1]].append((self.pid, fd))
+        ret = _connections.retrieve(kind, self.pid, inodes, conn_filter,
+                                    details)
         self._assert_alive()
         return ret
 
     @wrap_exceptions
     def num_fds(self):
-        return len(os.listdir("%s/%s/fd" % (self._procfs_path, self.pid)))
+        return len(self._list_fds())
 
     @wrap_exceptions
     def ppid(self):
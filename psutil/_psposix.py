@@ -107,17 +107,22 @@ def wait_pid(pid, timeout=None, proc_name=None):
                 # WNOHANG was used, pid is still running
                 delay = check_timeout(delay)
                 continue
-            # process exited due to a signal; return the integer of
-            # that signal
-            if os.WIFSIGNALED(status):
-                return -os.WTERMSIG(status)
-            # process exited using exit(2) system call; return the
-            # integer exit(2) system call has been called with
-            elif os.WIFEXITED(status):
-                return os.WEXITSTATUS(status)
-            else:
-                # should never happen
-                raise ValueError("unknown process exit status %r" % status)
+            return convert_exit_status(status)
+
+
+def convert_exit_status(status):
+    """Convert a status returned by os.waitpid() into an exit code."""
+    # process exited due to a signal; return the integer of
+    # that signal
+    if os.WIFSIGNALED(status):
+        return -os.WTERMSIG(status)
+    # process exited using exit(2) system call; return the
+    # integer exit(2) system call has been called with
+    elif os.WIFEXITED(status):
+        return os.WEXITSTATUS(status)
+    else:
+        # should never happen
+        raise ValueError("unknown process exit status %r" % status)
 
 
 def disk_usage(path):
@@ -54,8 +54,34 @@ static const int NCPUS_START = sizeof(unsigned long) * CHAR_BIT;
     #include <sys/resource.h>
 #endif
 
+// Linux >= 5.3 (pidfd_send_signal() >= 5.1). glibc provides no wrapper
+// and old kernel headers may not define the syscall numbers. These are
+// provided for the archs sharing the unified syscall table numbers
+// (plus alpha); others (e.g. MIPS, ia64, x32) have different ones and
+// need recent headers, else ENOSYS is returned. On older kernels the
+// syscalls fail with ENOSYS as well.
+#if defined(__alpha__)
+    #define PSUTIL_NR_PIDFD_OFFSET 110
+#elif (defined(__x86_64__) && !defined(__ILP32__)) || defined(__i386__) || \
+        defined(__aarch64__) || defined(__arm__) || \
+        defined(__powerpc__) || defined(__s390__) || defined(__riscv)
+    #define PSUTIL_NR_PIDFD_OFFSET 0
+#endif
+#if !defined(__NR_pidfd_open) && defined(PSUTIL_NR_PIDFD_OFFSET)
+    #define __NR_pidfd_open (434 + PSUTIL_NR_PIDFD_OFFSET)
+#endif
+#if !defined(__NR_pidfd_send_signal) && defined(PSUTIL_NR_PIDFD_OFFSET)
+    #define __NR_pidfd_send_signal (424 + PSUTIL_NR_PIDFD_OFFSET)
+#endif
+
 #include "_psutil_common.h"
 #include "_psutil_posix.h"
+#include "arch/linux/cpu.h"
+#include "arch/linux/proc.h"
+#include "arch/linux/proc_events.h"
+#include "arch/linux/rtnetlink.h"
+#include "arch/linux/sock_diag.h"
+#include "arch/linux/sysfs.h"
 
 // May happen on old RedHat versions, see:
 // https://github.com/giampaolo/psutil/issues/607
@@ -127,6 +153,52 @@ psutil_proc_ioprio_set(PyObject *self, PyObject *args) {
 #endif
 
 
+/*
+ * Return a file descriptor referring to the process (a pidfd), which
+ * becomes readable once the process terminates. Requires Linux 5.3.
+ */
+static PyObject *
+psutil_proc_pidfd_open(PyObject *self, PyObject *args) {
+    long pid;
+    int fd;
+
+    if (! PyArg_ParseTuple(args, "l", &pid))
+        return NULL;
+#ifdef __NR_pidfd_open
+    fd = syscall(__NR_pidfd_open, (pid_t)pid, 0);
+#else
+    fd = -1;
+    errno = ENOSYS;
+#endif
+    if (fd == -1)
+        return PyErr_SetFromErrno(PyExc_OSError);
+    return Py_BuildValue("i", fd);
+}
+
+
+/*
+ * Send a signal to the process referred to by a pidfd. Differently
+ * from kill() the signal can't be delivered to another process in
+ * case the PID has been reused. Requires Linux 5.1.
+ */
+static PyObject *
+psutil_proc_pidfd_send_signal(PyObject *self, PyObject *args) {
+    int fd;
+    int sig;
+
+    if (! PyArg_ParseTuple(args, "ii", &fd, &sig))
+        return NULL;
+#ifdef __NR_pidfd_send_signal
+    if (syscall(__NR_pidfd_send_signal, fd, sig, NULL, 0) == -1)
+        return PyErr_SetFromErrno(PyExc_OSError);
+#else
+    errno = ENOSYS;
+    return PyErr_SetFromErrno(PyExc_OSError);
+#endif
+    Py_RETURN_NONE;
+}
+
+
 #if PSUTIL_HAVE_PRLIMIT
 /*
  * A wrapper around prlimit(2); sets process resource limits.
@@ -522,13 +594,9 @@ error:
 static PyObject*
 psutil_net_if_duplex_speed(PyObject* self, PyObject* args) {
     char *nic_name;
-    int sock = 0;
-    int ret;
+    int sock;
     int duplex;
     int speed;
-    struct ifreq ifr;
-    struct ethtool_cmd ethcmd;
-    PyObject *py_retlist = NULL;
 
     if (! PyArg_ParseTuple(args, "s", &nic_name))
         return NULL;
@@ -536,43 +604,13 @@ psutil_net_if_duplex_speed(PyObject* self, PyObject* args) {
     sock = socket(AF_INET, SOCK_DGRAM, 0);
     if (sock == -1)
         return PyErr_SetFromOSErrnoWithSyscall("socket()");
-    strncpy(ifr.ifr_name, nic_name, sizeof(ifr.ifr_name));
-
-    // duplex and speed
-    memset(&ethcmd, 0, sizeof ethcmd);
-    ethcmd.cmd = ETHTOOL_GSET;
-    ifr.ifr_data = (void *)&ethcmd;
-    ret = ioctl(sock, SIOCETHTOOL, &ifr);
-
-    if (ret != -1) {
-        duplex = ethcmd.duplex;
-        speed = ethcmd.speed;
-    }
-    else {
-        if ((errno == EOPNOTSUPP) || (errno == EINVAL)) {
-            // EOPNOTSUPP may occur in case of wi-fi cards.
-            // For EINVAL see:
-            // https://github.com/giampaolo/psutil/issues/797
-            //     #issuecomment-202999532
-            duplex = DUPLEX_UNKNOWN;
-            speed = 0;
-        }
-        else {
-            PyErr_SetFromOSErrnoWithSyscall("ioctl(SIOCETHTOOL)");
-            goto error;
-        }
+    if (psutil_ethtool_duplex_speed(sock, nic_name, &duplex, &speed) != 0) {
+        PyErr_SetFromOSErrnoWithSyscall("ioctl(SIOCETHTOOL)");
+        close(sock);
+        return NULL;
     }
-
-    py_retlist = Py_BuildValue("[ii]", duplex, speed);
-    if (!py_retlist)
-        goto error;
     close(sock);
-    return py_retlist;
-
-error:
-    if (sock != -1)
-        close(sock);
-    return NULL;
+    return Py_BuildValue("[ii]", duplex, speed);
 }
 
 
@@ -589,10 +627,48 @@ PsutilMethods[] = {
     {"proc_ioprio_set", psutil_proc_ioprio_set, METH_VARARGS,
      "Set process I/O priority"},
 #endif
+    {"proc_pidfd_open", psutil_proc_pidfd_open, METH_VARARGS,
+     "Return a pidfd referring to the process."},
+    {"proc_pidfd_send_signal", psutil_proc_pidfd_send_signal, METH_VARARGS,
+     "Send a signal to the process referred to by a pidfd."},
     {"proc_cpu_affinity_get", psutil_proc_cpu_affinity_get, METH_VARARGS,
      "Return process CPU affinity as a Python long (the bitmask)."},
     {"proc_cpu_affinity_set", psutil_proc_cpu_affinity_set, METH_VARARGS,
      "Set process CPU affinity; expects a bitmask."},
+    {"proc_stat_scan", psutil_proc_stat_scan, METH_VARARGS,
+     "Read /proc/[pid]/stat of all processes in one shot."},
+    {"proc_counters_scan", psutil_proc_counters_scan, METH_VARARGS,
+     "Read stat, io and status files of all processes in one shot."},
+    {"proc_socket_inodes", psutil_proc_socket_inodes, METH_VARARGS,
+     "Map socket inodes to the (pid, fd) of all processes."},
+    {"proc_watch_open", psutil_proc_watch_open, METH_VARARGS,
+     "Open /proc/[pid] and some files in it, keeping them open."},
+    {"proc_pread", psutil_proc_pread, METH_VARARGS,
+     "Read the whole content of an open /proc file via pread()."},
+    {"proc_smaps_totals", psutil_proc_smaps_totals, METH_VARARGS,
+     "Return (uss, pss, swap) by streaming /proc/[pid]/smaps."},
+    {"proc_smaps_parse", psutil_proc_smaps_parse, METH_VARARGS,
+     "Parse a chunk of /proc/[pid]/smaps, filtering mappings."},
+    {"proc_events_open", psutil_proc_events_open, METH_VARARGS,
+     "Open a netlink socket notifying process fork/exit events."},
+    {"proc_events_read", psutil_proc_events_read, METH_VARARGS,
+     "Read the process events queued on the proc connector socket."},
+    {"cpu_stat_parse", psutil_cpu_stat_parse, METH_VARARGS,
+     "Parse the per-CPU times of /proc/stat into a sample"},
+    {"cpu_stat_times", psutil_cpu_stat_times, METH_VARARGS,
+     "Return the per-CPU times of a sample"},
+    {"cpu_stat_percent", psutil_cpu_stat_percent, METH_VARARGS,
+     "Return the per-CPU utilization percentage between two samples"},
+    {"cpu_stat_times_percent", psutil_cpu_stat_times_percent, METH_VARARGS,
+     "Return the per-CPU times percentages between two samples"},
+    {"sysfs_open", psutil_sysfs_open, METH_VARARGS,
+     "Open the given sysfs files and return their fds"},
+    {"sysfs_read", psutil_sysfs_read, METH_VARARGS,
+     "Re-read the sysfs files opened by sysfs_open()"},
+    {"net_inet_diag", psutil_net_inet_diag, METH_VARARGS,
+     "Dump TCP or UDP sockets via NETLINK_SOCK_DIAG."},
+    {"net_unix_diag", psutil_net_unix_diag, METH_VARARGS,
+     "Dump UNIX sockets and their peers via NETLINK_SOCK_DIAG."},
 
     // --- system related functions
 
@@ -603,6 +679,12 @@ PsutilMethods[] = {
      "Return currently connected users as a list of tuples"},
     {"net_if_duplex_speed", psutil_net_if_duplex_speed, METH_VARARGS,
      "Return duplex and speed info about a NIC"},
+    {"net_io_counters", psutil_net_io_counters, METH_VARARGS,
+     "Return the 64-bit I/O counters of all NICs via RTM_GETLINK"},
+    {"net_if_stats", psutil_net_if_stats, METH_VARARGS,
+     "Return isup, duplex, speed and MTU of all NICs via RTM_GETLINK"},
+    {"net_if_addrs", psutil_net_if_addrs, METH_VARARGS,
+     "Return NICs addresses via RTM_GETLINK and RTM_GETADDR"},
 
     // --- linux specific
 
@@ -677,6 +759,10 @@ void init_psutil_linux(void)
         INITERROR;
 
     PyModule_AddIntConstant(module, "version", PSUTIL_VERSION);
+    PyModule_AddIntConstant(
+        module, "PROC_EVENT_FORK", PSUTIL_PROC_EVENT_FORK);
+    PyModule_AddIntConstant(
+        module, "PROC_EVENT_EXIT", PSUTIL_PROC_EVENT_EXIT);
 #if PSUTIL_HAVE_PRLIMIT
     PyModule_AddIntConstant(module, "RLIMIT_AS", RLIMIT_AS);
     PyModule_AddIntConstant(module, "RLIMIT_CORE", RLIMIT_CORE);
@@ -0,0 +1,420 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Per-CPU times. The "cpuN" lines of /proc/stat are parsed into a
+ * sample (a bytes object holding an array of clock ticks) and the
+ * deltas and percentages of cpu_percent(percpu=True) and
+ * cpu_times_percent(percpu=True) are computed from two samples, so
+ * that Python objects are only built for the final result. The math
+ * is the same as in psutil/__init__.py.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpu.h"
+
+// user, nice, system, idle, iowait, irq, softirq, [steal, [guest,
+// [guest_nice]]]
+#define PSUTIL_CPU_MIN_FIELDS 7
+#define PSUTIL_CPU_MAX_FIELDS 10
+#define PSUTIL_CPU_IDLE 3
+#define PSUTIL_CPU_IOWAIT 4
+#define PSUTIL_CPU_GUEST 8
+#define PSUTIL_CPU_GUEST_NICE 9
+#if PY_MAJOR_VERSION >= 3
+    #define PSUTIL_CPU_BYTES "y#"
+#else
+    #define PSUTIL_CPU_BYTES "s#"
+#endif
+
+
+// A sample starts with this header, followed by "ncpus" rows of
+// PSUTIL_CPU_MAX_FIELDS uint64_t tick counters (missing fields are 0).
+typedef struct {
+    uint32_t ncpus;
+    uint32_t nfields;
+    double clock_ticks;
+} psutil_cpu_sample;
+
+
+/*
+ * Validate a sample passed from Python and copy its header into
+ * "sample". Return a pointer to its rows or NULL on error. The header
+ * is not trusted: nfields is used to index fixed size arrays.
+ */
+static const char *
+psutil_cpu_sample_rows(const char *data, Py_ssize_t size,
+                       psutil_cpu_sample *sample) {
+    size_t rowsize = PSUTIL_CPU_MAX_FIELDS * sizeof(uint64_t);
+    size_t rowsbytes;
+
+    if ((size_t)size >= sizeof(*sample)) {
+        memcpy(sample, data, sizeof(*sample));
+        rowsbytes = (size_t)size - sizeof(*sample);
+        if (sample->nfields >= PSUTIL_CPU_MIN_FIELDS &&
+                sample->nfields <= PSUTIL_CPU_MAX_FIELDS &&
+                sample->clock_ticks > 0 &&
+                rowsbytes % rowsize == 0 &&
+                sample->ncpus == rowsbytes / rowsize)
+            return data + sizeof(*sample);
+    }
+    PyErr_SetString(PyExc_ValueError, "invalid CPU times sample");
+    return NULL;
+}
+
+
+/*
+ * Return the "field" value of the "cpu" row of a sample, in seconds.
+ * Rows are not necessarily aligned, hence memcpy().
+ */
+static double
+psutil_cpu_sample_value(const char *rows, const psutil_cpu_sample *sample,
+                        size_t cpu, size_t field) {
+    uint64_t value;
+
+    memcpy(&value,
+           rows + (cpu * PSUTIL_CPU_MAX_FIELDS + field) * sizeof(uint64_t),
+           sizeof(value));
+    return (double)value / sample->clock_ticks;
+}
+
+
+/*
+ * Same as Python's round(x, 1), which is correctly rounded on Python
+ * >= 2.7 (e.g. round(0.15, 1) is 0.1 since 0.15 is 0.1499999...).
+ * Return -1 on error.
+ */
+static double
+psutil_cpu_round(double x) {
+#if PY_VERSION_HEX >= 0x02070000
+    char *s;
+    double ret;
+
+    s = PyOS_double_to_string(x, 'f', 1, 0, NULL);
+    if (s == NULL)
+        return -1;
+    ret = PyOS_string_to_double(s, NULL, NULL);
+    PyMem_Free(s);
+    return ret;
+#else
+    return floor(x * 10.0 + 0.5) / 10.0;
+#endif
+}
+
+
+/*
+ * Compute the deltas of every field between the samples "t1" and "t2"
+ * of a CPU and return the total CPU time (including idle time).
+ * Negative deltas (times should never decrease but sometimes do) are
+ * trimmed to zero and guest times are subtracted from the total as
+ * they are already accounted in "user" and "nice" times.
+ */
+static double
+psutil_cpu_deltas(const char *rows1, const psutil_cpu_sample *s1,
+                  const char *rows2, const psutil_cpu_sample *s2,
+                  size_t cpu, double *deltas) {
+    size_t i;
+    double tot = 0;
+
+    for (i = 0; i < s1->nfields; i++) {
+        deltas[i] = psutil_cpu_sample_value(rows2, s2, cpu, i) -
+                    psutil_cpu_sample_value(rows1, s1, cpu, i);
+        if (deltas[i] < 0)
+            deltas[i] = 0;
+        tot += deltas[i];
+    }
+    if (s1->nfields > PSUTIL_CPU_GUEST)
+        tot -= deltas[PSUTIL_CPU_GUEST];
+    if (s1->nfields > PSUTIL_CPU_GUEST_NICE)
+        tot -= deltas[PSUTIL_CPU_GUEST_NICE];
+    return tot;
+}
+
+
+/*
+ * Parse two samples passed as arguments. Return the number of CPUs
+ * they have in common (like zip()) or -1 on error.
+ */
+static Py_ssize_t
+psutil_cpu_parse_samples(PyObject *args,
+                         const char **rows1, psutil_cpu_sample *s1,
+                         const char **rows2, psutil_cpu_sample *s2) {
+    const char *data1;
+    const char *data2;
+    Py_ssize_t size1;
+    Py_ssize_t size2;
+
+    if (! PyArg_ParseTuple(args, PSUTIL_CPU_BYTES PSUTIL_CPU_BYTES,
+                           &data1, &size1, &data2, &size2))
+        return -1;
+    if ((*rows1 = psutil_cpu_sample_rows(data1, size1, s1)) == NULL)
+        return -1;
+    if ((*rows2 = psutil_cpu_sample_rows(data2, size2, s2)) == NULL)
+        return -1;
+    if (s1->nfields != s2->nfields) {
+        PyErr_SetString(PyExc_ValueError,
+                        "CPU times samples have different fields");
+        return -1;
+    }
+    return s1->ncpus < s2->ncpus ? s1->ncpus : s2->ncpus;
+}
+
+
+/*
+ * Parse the content of /proc/stat and return a (nfields, sample)
+ * tuple. "nfields" is the number of CPU times reported by the kernel
+ * (between 7 and 10, depending on its version) and "sample" holds the
+ * times of every "cpuN" line, in clock ticks, to be passed to the
+ * functions below.
+ */
+PyObject *
+psutil_cpu_stat_parse(PyObject *self, PyObject *args) {
+    const char *data;
+    const char *end;
+    const char *pos;
+    const char *eol;
+    char *endptr;
+    char *rows;
+    Py_ssize_t size;
+    size_t rowsize = PSUTIL_CPU_MAX_FIELDS * sizeof(uint64_t);
+    size_t i;
+    uint64_t values[PSUTIL_CPU_MAX_FIELDS];
+    psutil_cpu_sample sample;
+    PyObject *py_sample = NULL;
+    PyObject *py_retlist;
+
+    if (! PyArg_ParseTuple(args, PSUTIL_CPU_BYTES "d",
+                           &data, &size, &sample.clock_ticks))
+        return NULL;
+    if (sample.clock_ticks <= 0) {
+        PyErr_SetString(PyExc_ValueError, "invalid clock ticks");
+        return NULL;
+    }
+
+    // First pass: count "cpuN" lines, which are at the beginning of
+    // the file, and the fields of the system-wide "cpu" line.
+    sample.ncpus = 0;
+    sample.nfields = 0;
+    end = data + size;
+    for (pos = data; pos < end; pos = eol + 1) {
+        eol = memchr(pos, '\n', end - pos);
+        if (eol == NULL)
+            eol = end;
+        if (eol - pos < 3 || strncmp(pos, "cpu", 3) != 0)
+            break;
+        if (pos[3] >= '0' && pos[3] <= '9') {
+            sample.ncpus++;
+        }
+        else if (pos == data) {
+            for (pos += 3; sample.nfields < PSUTIL_CPU_MAX_FIELDS;
+                    sample.nfields++) {
+                strtoull(pos, &endptr, 10);
+                if (endptr == pos || endptr > eol)
+                    break;
+                pos = endptr;
+            }
+        }
+    }
+    if (sample.nfields < PSUTIL_CPU_MIN_FIELDS)
+        sample.nfields = PSUTIL_CPU_MIN_FIELDS;
+
+    // Second pass: fill the preallocated rows.
+    py_sample = PyBytes_FromStringAndSize(
+        NULL, sizeof(sample) + sample.ncpus * rowsize);
+    if (py_sample == NULL)
+        return NULL;
+    memcpy(PyBytes_AS_STRING(py_sample), &sample, sizeof(sample));
+    rows = PyBytes_AS_STRING(py_sample) + sizeof(sample);
+    for (pos = data; pos < end && rows < PyBytes_AS_STRING(py_sample) +
+            PyBytes_GET_SIZE(py_sample); pos = eol + 1) {
+        eol = memchr(pos, '\n', end - pos);
+        if (eol == NULL)
+            eol = end;
+        if (! (pos[3] >= '0' && pos[3] <= '9'))
+            continue;  // the system-wide "cpu" line
+        // skip "cpuN"
+        for (pos += 4; pos < eol && *pos != ' '; pos++)
+            ;
+        for (i = 0; i < PSUTIL_CPU_MAX_FIELDS; i++) {
+            values[i] = 0;
+            if (i < sample.nfields) {
+                values[i] = strtoull(pos, &endptr, 10);
+                if (endptr == pos || endptr > eol)
+                    values[i] = 0;
+                else
+                    pos = endptr;
+            }
+        }
+        memcpy(rows, values, rowsize);
+        rows += rowsize;
+    }
+
+    py_retlist = Py_BuildValue("(IO)", sample.nfields, py_sample);
+    Py_DECREF(py_sample);
+    return py_retlist;
+}
+
+
+/*
+ * Return the times of every CPU of a sample as a list of tuples of
+ * floats (seconds).
+ */
+PyObject *
+psutil_cpu_stat_times(PyObject *self, PyObject *args) {
+    const char *data;
+    const char *rows;
+    Py_ssize_t size;
+    size_t cpu;
+    size_t i;
+    psutil_cpu_sample sample;
+    PyObject *py_tuple = NULL;
+    PyObject *py_value;
+    PyObject *py_retlist;
+
+    if (! PyArg_ParseTuple(args, PSUTIL_CPU_BYTES, &data, &size))
+        return NULL;
+    if ((rows = psutil_cpu_sample_rows(data, size, &sample)) == NULL)
+        return NULL;
+    py_retlist = PyList_New(sample.ncpus);
+    if (py_retlist == NULL)
+        return NULL;
+
+    for (cpu = 0; cpu < sample.ncpus; cpu++) {
+        py_tuple = PyTuple_New(sample.nfields);
+        if (py_tuple == NULL)
+            goto error;
+        for (i = 0; i < sample.nfields; i++) {
+            py_value = PyFloat_FromDouble(
+                psutil_cpu_sample_value(rows, &sample, cpu, i));
+            if (py_value == NULL)
+                goto error;
+            PyTuple_SET_ITEM(py_tuple, i, py_value);
+        }
+        PyList_SET_ITEM(py_retlist, cpu, py_tuple);
+        py_tuple = NULL;
+    }
+    return py_retlist;
+
+error:
+    Py_XDECREF(py_tuple);
+    Py_DECREF(py_retlist);
+    return NULL;
+}
+
+
+/*
+ * Given two samples return the utilization percentage of every CPU
+ * as a list of floats, as cpu_percent(percpu=True).
+ */
+PyObject *
+psutil_cpu_stat_percent(PyObject *self, PyObject *args) {
+    const char *rows1;
+    const char *rows2;
+    Py_ssize_t ncpus;
+    Py_ssize_t cpu;
+    double deltas[PSUTIL_CPU_MAX_FIELDS];
+    double tot;
+    double busy;
+    double percent;
+    psutil_cpu_sample s1;
+    psutil_cpu_sample s2;
+    PyObject *py_value;
+    PyObject *py_retlist;
+
+    ncpus = psutil_cpu_parse_samples(args, &rows1, &s1, &rows2, &s2);
+    if (ncpus == -1)
+        return NULL;
+    py_retlist = PyList_New(ncpus);
+    if (py_retlist == NULL)
+        return NULL;
+
+    for (cpu = 0; cpu < ncpus; cpu++) {
+        tot = psutil_cpu_deltas(rows1, &s1, rows2, &s2, cpu, deltas);
+        // On Linux IO wait is *not* accounted in idle time.
+        busy = tot - deltas[PSUTIL_CPU_IDLE] - deltas[PSUTIL_CPU_IOWAIT];
+        if (tot == 0) {
+            percent = 0.0;
+        }
+        else {
+            percent = psutil_cpu_round((busy / tot) * 100);
+            if (percent == -1 && PyErr_Occurred())
+                goto error;
+        }
+        py_value = PyFloat_FromDouble(percent);
+        if (py_value == NULL)
+            goto error;
+        PyList_SET_ITEM(py_retlist, cpu, py_value);
+    }
+    return py_retlist;
+
+error:
+    Py_DECREF(py_retlist);
+    return NULL;
+}
+
+
+/*
+ * Given two samples return the utilization percentage of every CPU
+ * time of every CPU as a list of tuples of floats, as
+ * cpu_times_percent(percpu=True).
+ */
+PyObject *
+psutil_cpu_stat_times_percent(PyObject *self, PyObject *args) {
+    const char *rows1;
+    const char *rows2;
+    Py_ssize_t ncpus;
+    Py_ssize_t cpu;
+    size_t i;
+    double deltas[PSUTIL_CPU_MAX_FIELDS];
+    double tot;
+    double scale;
+    double percent;
+    psutil_cpu_sample s1;
+    psutil_cpu_sample s2;
+    PyObject *py_tuple = NULL;
+    PyObject *py_value;
+    PyObject *py_retlist;
+
+    ncpus = psutil_cpu_parse_samples(args, &rows1, &s1, &rows2, &s2);
+    if (ncpus == -1)
+        return NULL;
+    py_retlist = PyList_New(ncpus);
+    if (py_retlist == NULL)
+        return NULL;
+
+    for (cpu = 0; cpu < ncpus; cpu++) {
+        tot = psutil_cpu_deltas(rows1, &s1, rows2, &s2, cpu, deltas);
+        // Same as psutil/__init__.py: max() avoids division by zero.
+        scale = 100.0 / (tot > 1 ? tot : 1);
+        py_tuple = PyTuple_New(s1.nfields);
+        if (py_tuple == NULL)
+            goto error;
+        for (i = 0; i < s1.nfields; i++) {
+            percent = psutil_cpu_round(deltas[i] * scale);
+            if (percent == -1 && PyErr_Occurred())
+                goto error;
+            // make sure we don't return values over 100%
+            if (percent > 100.0)
+                percent = 100.0;
+            py_value = PyFloat_FromDouble(percent);
+            if (py_value == NULL)
+                goto error;
+            PyTuple_SET_ITEM(py_tuple, i, py_value);
+        }
+        PyList_SET_ITEM(py_retlist, cpu, py_tuple);
+        py_tuple = NULL;
+    }
+    return py_retlist;
+
+error:
+    Py_XDECREF(py_tuple);
+    Py_DECREF(py_retlist);
+    return NULL;
+}
@@ -0,0 +1,12 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <Python.h>
+
+PyObject* psutil_cpu_stat_parse(PyObject* self, PyObject* args);
+PyObject* psutil_cpu_stat_times(PyObject* self, PyObject* args);
+PyObject* psutil_cpu_stat_percent(PyObject* self, PyObject* args);
+PyObject* psutil_cpu_stat_times_percent(PyObject* self, PyObject* args);
@@ -0,0 +1,191 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Generic netlink dump loop shared by NETLINK_SOCK_DIAG (sockets) and
+ * NETLINK_ROUTE (network interfaces) based functions.
+ */
+
+#include <Python.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <linux/netlink.h>
+
+#include "../../_psutil_common.h"
+#include "netlink.h"
+
+#define PSUTIL_NETLINK_BUFSIZE 65536
+
+
+// Argument of psutil_netlink_netns_thread().
+typedef struct {
+    int protocol;
+    int netns_fd;
+    int sock;
+    int err;
+    const char *syscall;
+} psutil_netlink_netns_args;
+
+
+/*
+ * Thread body: join the network namespace referred to by netns_fd and
+ * create a netlink socket in there. Network namespaces are per thread
+ * and a socket stays bound to the namespace it was created in, so this
+ * leaves the namespace of the calling thread untouched.
+ */
+static void *
+psutil_netlink_netns_thread(void *arg) {
+    psutil_netlink_netns_args *args = (psutil_netlink_netns_args *)arg;
+
+    if (setns(args->netns_fd, CLONE_NEWNET) == -1) {
+        args->err = errno;
+        args->syscall = "setns(CLONE_NEWNET)";
+        return NULL;
+    }
+    args->sock = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC,
+                        args->protocol);
+    if (args->sock == -1) {
+        args->err = errno;
+        args->syscall = "socket(AF_NETLINK)";
+    }
+    return NULL;
+}
+
+
+/*
+ * Create a "protocol" netlink socket in the network namespace referred
+ * to by "netns_fd" (a /proc/[pid]/ns/net fd), or in the current one if
+ * it is -1. Return the socket, else -1 with a Python exception set.
+ */
+static int
+psutil_netlink_socket(int protocol, int netns_fd) {
+    int ret;
+    int sock;
+    pthread_t thread;
+    psutil_netlink_netns_args args;
+
+    if (netns_fd == -1) {
+        sock = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, protocol);
+        if (sock == -1)
+            PyErr_SetFromOSErrnoWithSyscall("socket(AF_NETLINK)");
+        return sock;
+    }
+
+    args.protocol = protocol;
+    args.netns_fd = netns_fd;
+    args.sock = -1;
+    args.err = 0;
+    args.syscall = NULL;
+    Py_BEGIN_ALLOW_THREADS
+    ret = pthread_create(&thread, NULL, psutil_netlink_netns_thread, &args);
+    if (ret == 0)
+        pthread_join(thread, NULL);
+    Py_END_ALLOW_THREADS
+    if (ret != 0) {
+        errno = ret;
+        PyErr_SetFromOSErrnoWithSyscall("pthread_create");
+        return -1;
+    }
+    if (args.sock == -1) {
+        errno = args.err;
+        PyErr_SetFromOSErrnoWithSyscall(args.syscall);
+        return -1;
+    }
+    return args.sock;
+}
+
+
+/*
+ * Send a netlink dump request (a message starting with a struct
+ * nlmsghdr, whose length, flags and sequence number are set in here)
+ * over a "protocol" netlink socket and call "callback" for every
+ * message received in reply. "netns_fd" is the network namespace to
+ * query, see psutil_netlink_socket().
+ * Return 0 on success, else -1 with a Python exception set.
+ */
+int
+psutil_netlink_dump(int protocol, int netns_fd, void *req, size_t reqlen,
+                    psutil_netlink_cb callback, void *arg) {
+    int sock;
+    int done = 0;
+    ssize_t len;
+    char *buf = NULL;
+    struct nlmsghdr *nlh = (struct nlmsghdr *)req;
+    struct nlmsgerr *nlerr;
+    struct sockaddr_nl addr;
+    struct iovec iov;
+    struct msghdr msg;
+
+    sock = psutil_netlink_socket(protocol, netns_fd);
+    if (sock == -1)
+        return -1;
+
+    nlh->nlmsg_len = reqlen;
+    nlh->nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    nlh->nlmsg_seq = 1;
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    iov.iov_base = req;
+    iov.iov_len = reqlen;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_name = &addr;
+    msg.msg_namelen = sizeof(addr);
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    if (sendmsg(sock, &msg, 0) == -1) {
+        PyErr_SetFromOSErrnoWithSyscall("sendmsg(AF_NETLINK)");
+        goto error;
+    }
+
+    buf = malloc(PSUTIL_NETLINK_BUFSIZE);
+    if (buf == NULL) {
+        PyErr_NoMemory();
+        goto error;
+    }
+    while (! done) {
+        Py_BEGIN_ALLOW_THREADS
+        len = recv(sock, buf, PSUTIL_NETLINK_BUFSIZE, 0);
+        Py_END_ALLOW_THREADS
+        if (len == -1) {
+            if (errno == EINTR)
+                continue;
+            PyErr_SetFromOSErrnoWithSyscall("recv(AF_NETLINK)");
+            goto error;
+        }
+        if (len == 0)
+            break;
+        for (nlh = (struct nlmsghdr *)buf;
+                NLMSG_OK(nlh, (unsigned int)len);
+                nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type == NLMSG_DONE) {
+                done = 1;
+                break;
+            }
+            if (nlh->nlmsg_type == NLMSG_ERROR) {
+                nlerr = (struct nlmsgerr *)NLMSG_DATA(nlh);
+                // e.g. ENOENT if the protocol is not supported
+                errno = -nlerr->error;
+                PyErr_SetFromOSErrnoWithSyscall("NLMSG_ERROR");
+                goto error;
+            }
+            if (callback(nlh, arg) != 0)
+                goto error;
+        }
+    }
+
+    free(buf);
+    close(sock);
+    return 0;
+
+error:
+    free(buf);
+    close(sock);
+    return -1;
+}
@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <Python.h>
+#include <linux/netlink.h>
+
+// Called for every message of a netlink dump. Must return 0, or -1
+// with a Python exception set in order to stop the dump.
+typedef int (*psutil_netlink_cb)(struct nlmsghdr *nlh, void *arg);
+
+int psutil_netlink_dump(int protocol, int netns_fd, void *req,
+                        size_t reqlen, psutil_netlink_cb callback,
+                        void *arg);
@@ -0,0 +1,1236 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Bulk readers of /proc/[pid] files. Rather than opening and parsing
+ * one file per process from Python, these walk /proc with getdents64(2)
+ * and read the files relative to a directory fd into a reused buffer,
+ * with the GIL released.
+ * Also helpers to keep /proc/[pid] files open and re-read them with
+ * pread(2), for processes which are sampled repeatedly.
+ */
+
+#ifndef _GNU_SOURCE
+    #define _GNU_SOURCE 1
+#endif
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <fnmatch.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+
+#include "../../_psutil_common.h"
+#include "proc.h"
+
+#define PSUTIL_DENTS_BUFSIZE 32768
+// Big enough for /proc/[pid]/status as well.
+#define PSUTIL_STAT_BUFSIZE 16384
+#define PSUTIL_SCAN_COUNTERS 1
+// Big enough for a single pread() of stat, statm, io and status.
+#define PSUTIL_PREAD_BUFSIZE 4096
+#define PSUTIL_SMAPS_LINESIZE 256
+#define PSUTIL_SMAPS_NFIELDS 10
+#if PY_MAJOR_VERSION >= 3
+    #define PSUTIL_SMAPS_PARSE_ARGS "y#izzO"
+#else
+    #define PSUTIL_SMAPS_PARSE_ARGS "s#izzO"
+#endif
+
+
+/*
+ * Thin wrapper around the getdents64 syscall.
+ */
+int
+psutil_getdents64(int fd, char *buf, size_t size) {
+    return syscall(SYS_getdents64, fd, buf, size);
+}
+
+
+/*
+ * Return 1 if a /proc directory entry name is made of digits only.
+ */
+int
+psutil_is_pid_name(const char *name) {
+    if (*name == '\0')
+        return 0;
+    for (; *name; name++) {
+        if (*name < '0' || *name > '9')
+            return 0;
+    }
+    return 1;
+}
+
+
+/*
+ * Per-process fields collected by psutil_proc_scan(). The ones below
+ * "processor" are only filled in if PSUTIL_SCAN_COUNTERS is passed
+ * and are set to -1 if they can't be determined (e.g. /proc/[pid]/io
+ * is not readable).
+ */
+typedef struct {
+    long pid;
+    long ppid;
+    char status;
+    unsigned long long utime;
+    unsigned long long stime;
+    unsigned long long starttime;
+    long rss;
+    unsigned long minflt;
+    unsigned long majflt;
+    long num_threads;
+    int processor;
+    long long read_bytes;
+    long long write_bytes;
+    long long vol_ctxsw;
+    long long invol_ctxsw;
+} psutil_proc_entry;
+
+
+/*
+ * Parse the content of a /proc/[pid]/stat file. Using "man proc" as a
+ * reference: where "man proc" refers to position N, subtract 3 to get
+ * the index used in here (e.g. ppid position 4 == index 1).
+ * Return 0 on success, -1 if the content is malformed.
+ */
+static int
+psutil_parse_stat(char *data, psutil_proc_entry *entry) {
+    char *p;
+    char *end;
+    long long value;
+    int i;
+
+    // The process name is between parentheses and it can contain
+    // spaces and other parentheses, hence we look for the last ")".
+    p = strrchr(data, ')');
+    if (p == NULL || p[1] == '\0' || p[2] == '\0')
+        return -1;
+    p += 2;
+    entry->status = *p++;
+    entry->processor = -1;
+    for (i = 1; i <= 36; i++) {
+        while (*p == ' ')
+            p++;
+        if (*p == '\0' || *p == '\n')
+            break;
+        value = strtoll(p, &end, 10);
+        if (end == p)
+            return -1;
+        p = end;
+        switch (i) {
+            case 1:
+                entry->ppid = (long)value;
+                break;
+            case 7:
+                entry->minflt = (unsigned long)value;
+                break;
+            case 9:
+                entry->majflt = (unsigned long)value;
+                break;
+            case 11:
+                entry->utime = (unsigned long long)value;
+                break;
+            case 12:
+                entry->stime = (unsigned long long)value;
+                break;
+            case 17:
+                entry->num_threads = (long)value;
+                break;
+            case 19:
+                entry->starttime = (unsigned long long)value;
+                break;
+            case 21:
+                entry->rss = (long)value;
+                break;
+            case 36:
+                entry->processor = (int)value;
+                break;
+        }
+    }
+    // starttime is the last field we can't do without
+    return (i > 19) ? 0 : -1;
+}
+
+
+/*
+ * Read the whole content of a file relative to dirfd into buf,
+ * which is NULL terminated. Return the number of bytes read or -1.
+ */
+static ssize_t
+psutil_read_at(int dirfd, const char *path, char *buf, size_t size) {
+    int fd;
+    ssize_t ret;
+    size_t total = 0;
+
+    fd = openat(dirfd, path, O_RDONLY | O_CLOEXEC);
+    if (fd == -1)
+        return -1;
+    while (total < size - 1) {
+        ret = read(fd, buf + total, size - 1 - total);
+        if (ret == -1) {
+            if (errno == EINTR)
+                continue;
+            close(fd);
+            return -1;
+        }
+        if (ret == 0)
+            break;
+        total += ret;
+    }
+    close(fd);
+    buf[total] = '\0';
+    return total;
+}
+
+
+/*
+ * Return the integer value following "key" in a "key: value" text
+ * file such as /proc/[pid]/io or /proc/[pid]/status, or -1 if the
+ * key is not found. "key" must include the leading newline.
+ */
+static long long
+psutil_parse_keyval(const char *data, const char *key) {
+    const char *p;
+
+    p = strstr(data, key);
+    if (p == NULL)
+        return -1;
+    return strtoll(p + strlen(key), NULL, 10);
+}
+
+
+/*
+ * Walk procfs_path and read the files of every process into a
+ * dynamically allocated array of entries. The GIL must be released
+ * by the caller. Processes which disappear while scanning are
+ * skipped. Return 0 on success or an errno value.
+ */
+static int
+psutil_proc_scan(const char *procfs_path, int flags,
+                 psutil_proc_entry **retentries, size_t *retcount) {
+    int dirfd = -1;
+    int nread;
+    int pos;
+    int err = 0;
+    char *dents = NULL;
+    char *buf = NULL;
+    char path[64];
+    size_t count = 0;
+    size_t capacity = 1024;
+    struct psutil_dirent64 *dent;
+    psutil_proc_entry *entries = NULL;
+    psutil_proc_entry *entry;
+    psutil_proc_entry *tmp;
+
+    dents = malloc(PSUTIL_DENTS_BUFSIZE);
+    buf = malloc(PSUTIL_STAT_BUFSIZE);
+    entries = malloc(capacity * sizeof(psutil_proc_entry));
+    if (dents == NULL || buf == NULL || entries == NULL) {
+        err = ENOMEM;
+        goto done;
+    }
+
+    dirfd = open(procfs_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd == -1) {
+        err = errno;
+        goto done;
+    }
+    while (err == 0) {
+        nread = psutil_getdents64(dirfd, dents, PSUTIL_DENTS_BUFSIZE);
+        if (nread == -1) {
+            err = errno;
+            break;
+        }
+        if (nread == 0)
+            break;
+        for (pos = 0; pos < nread; pos += dent->d_reclen) {
+            dent = (struct psutil_dirent64 *)(dents + pos);
+            if (! psutil_is_pid_name(dent->d_name))
+                continue;
+            snprintf(path, sizeof(path), "%s/stat", dent->d_name);
+            errno = 0;
+            if (psutil_read_at(dirfd, path, buf, PSUTIL_STAT_BUFSIZE) <= 0) {
+                // Note: we should be able to access /stat for all
+                // processes aka it's unlikely we'll bump into EPERM.
+                // ENOENT / ESRCH just mean the process is gone.
+                if (errno == ENOENT || errno == ESRCH || errno == 0)
+                    continue;
+                err = errno;
+                break;
+            }
+            if (count == capacity) {
+                capacity *= 2;
+                tmp = realloc(entries, capacity * sizeof(psutil_proc_entry));
+                if (tmp == NULL) {
+                    err = ENOMEM;
+                    break;
+                }
+                entries = tmp;
+            }
+            entry = &entries[count];
+            memset(entry, 0, sizeof(psutil_proc_entry));
+            entry->pid = strtol(dent->d_name, NULL, 10);
+            if (psutil_parse_stat(buf, entry) != 0) {
+                psutil_debug("can't parse %s/%s", procfs_path, path);
+                continue;
+            }
+
+            if (flags & PSUTIL_SCAN_COUNTERS) {
+                // /proc/[pid]/io is only readable by the process owner.
+                snprintf(path, sizeof(path), "%s/io", dent->d_name);
+                if (psutil_read_at(dirfd, path, buf,
+                                   PSUTIL_STAT_BUFSIZE) > 0) {
+                    entry->read_bytes = psutil_parse_keyval(
+                        buf, "\nread_bytes: ");
+                    entry->write_bytes = psutil_parse_keyval(
+                        buf, "\nwrite_bytes: ");
+                }
+                else {
+                    entry->read_bytes = -1;
+                    entry->write_bytes = -1;
+                }
+                snprintf(path, sizeof(path), "%s/status", dent->d_name);
+                if (psutil_read_at(dirfd, path, buf,
+                                   PSUTIL_STAT_BUFSIZE) > 0) {
+                    entry->vol_ctxsw = psutil_parse_keyval(
+                        buf, "\nvoluntary_ctxt_switches:");
+                    entry->invol_ctxsw = psutil_parse_keyval(
+                        buf, "\nnonvoluntary_ctxt_switches:");
+                }
+                else {
+                    entry->vol_ctxsw = -1;
+                    entry->invol_ctxsw = -1;
+                }
+            }
+            count++;
+        }
+    }
+
+done:
+    if (dirfd != -1)
+        close(dirfd);
+    free(dents);
+    free(buf);
+    if (err != 0) {
+        free(entries);
+        return err;
+    }
+    *retentries = entries;
+    *retcount = count;
+    return 0;
+}
+
+
+/*
+ * Set the Python exception matching the errno value returned by
+ * psutil_proc_scan().
+ */
+static void
+psutil_proc_scan_seterr(int err, char *procfs_path) {
+    if (err == ENOMEM) {
+        PyErr_NoMemory();
+    }
+    else {
+        errno = err;
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, procfs_path);
+    }
+}
+
+
+/*
+ * Read /proc/[pid]/stat for all running processes in one shot and
+ * return a list of (pid, ppid, status, utime, stime, starttime, rss,
+ * minflt, majflt, num_threads, processor) tuples.
+ * CPU times and starttime are expressed in clock ticks, rss in pages.
+ */
+PyObject *
+psutil_proc_stat_scan(PyObject *self, PyObject *args) {
+    char *procfs_path;
+    int err;
+    size_t count = 0;
+    size_t i;
+    psutil_proc_entry *entries = NULL;
+    PyObject *py_tuple = NULL;
+    PyObject *py_retlist = NULL;
+
+    if (! PyArg_ParseTuple(args, "s", &procfs_path))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    err = psutil_proc_scan(procfs_path, 0, &entries, &count);
+    Py_END_ALLOW_THREADS
+    if (err != 0) {
+        psutil_proc_scan_seterr(err, procfs_path);
+        return NULL;
+    }
+
+    py_retlist = PyList_New(0);
+    if (py_retlist == NULL)
+        goto error;
+    for (i = 0; i < count; i++) {
+        py_tuple = Py_BuildValue(
+            "(llcKKKlkkli)",
+            entries[i].pid,
+            entries[i].ppid,
+            entries[i].status,
+            entries[i].utime,
+            entries[i].stime,
+            entries[i].starttime,
+            entries[i].rss,
+            entries[i].minflt,
+            entries[i].majflt,
+            entries[i].num_threads,
+            entries[i].processor);
+        if (py_tuple == NULL)
+            goto error;
+        if (PyList_Append(py_retlist, py_tuple))
+            goto error;
+        Py_CLEAR(py_tuple);
+    }
+
+    free(entries);
+    return py_retlist;
+
+error:
+    Py_XDECREF(py_tuple);
+    Py_XDECREF(py_retlist);
+    free(entries);
+    return NULL;
+}
+
+
+/*
+ * Same as above but also read /proc/[pid]/io and /proc/[pid]/status
+ * and return a list of (pid, starttime, utime, stime, minflt, majflt,
+ * read_bytes, write_bytes, vol_ctxsw, invol_ctxsw) tuples.
+ * The last 4 values are -1 if they can't be determined.
+ */
+PyObject *
+psutil_proc_counters_scan(PyObject *self, PyObject *args) {
+    char *procfs_path;
+    int err;
+    size_t count = 0;
+    size_t i;
+    psutil_proc_entry *entries = NULL;
+    PyObject *py_tuple = NULL;
+    PyObject *py_retlist = NULL;
+
+    if (! PyArg_ParseTuple(args, "s", &procfs_path))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    err = psutil_proc_scan(procfs_path, PSUTIL_SCAN_COUNTERS,
+                           &entries, &count);
+    Py_END_ALLOW_THREADS
+    if (err != 0) {
+        psutil_proc_scan_seterr(err, procfs_path);
+        return NULL;
+    }
+
+    py_retlist = PyList_New(0);
+    if (py_retlist == NULL)
+        goto error;
+    for (i = 0; i < count; i++) {
+        py_tuple = Py_BuildValue(
+            "(lKKKkkLLLL)",
+            entries[i].pid,
+            entries[i].starttime,
+            entries[i].utime,
+            entries[i].stime,
+            entries[i].minflt,
+            entries[i].majflt,
+            entries[i].read_bytes,
+            entries[i].write_bytes,
+            entries[i].vol_ctxsw,
+            entries[i].invol_ctxsw);
+        if (py_tuple == NULL)
+            goto error;
+        if (PyList_Append(py_retlist, py_tuple))
+            goto error;
+        Py_CLEAR(py_tuple);
+    }
+
+    free(entries);
+    return py_retlist;
+
+error:
+    Py_XDECREF(py_tuple);
+    Py_XDECREF(py_retlist);
+    free(entries);
+    return NULL;
+}
+
+
+/*
+ * A socket file descriptor found by psutil_proc_fd_scan().
+ */
+typedef struct {
+    unsigned long inode;
+    long pid;
+    int fd;
+} psutil_sock_fd;
+
+
+static int
+psutil_cmp_inode(const void *a, const void *b) {
+    unsigned long x = *(const unsigned long *)a;
+    unsigned long y = *(const unsigned long *)b;
+    return (x > y) - (x < y);
+}
+
+
+/*
+ * Collect the socket fds of a single process by reading the
+ * /proc/[pid]/fd symlinks relative to the fd directory. Sockets whose
+ * inode is not in "wanted" (if any) are ignored, the others are marked
+ * as found. Return 0 on success, else an errno value.
+ */
+static int
+psutil_proc_fd_scan_pid(int fddir, long pid, char *dents,
+                        unsigned long *wanted, size_t nwanted,
+                        char *found, size_t *nfound,
+                        psutil_sock_fd **entries, size_t *count,
+                        size_t *capacity) {
+    int nread;
+    int pos;
+    ssize_t len;
+    char link[64];
+    char *end;
+    unsigned long inode;
+    unsigned long *match;
+    struct psutil_dirent64 *dent;
+    psutil_sock_fd *tmp;
+
+    while (1) {
+        nread = psutil_getdents64(fddir, dents, PSUTIL_DENTS_BUFSIZE);
+        if (nread == -1)
+            return errno;
+        if (nread == 0)
+            return 0;
+        for (pos = 0; pos < nread; pos += dent->d_reclen) {
+            dent = (struct psutil_dirent64 *)(dents + pos);
+            if (! psutil_is_pid_name(dent->d_name))
+                continue;
+            len = readlinkat(fddir, dent->d_name, link, sizeof(link) - 1);
+            if (len == -1)
+                continue;  // fd closed in the meantime
+            link[len] = '\0';
+            if (strncmp(link, "socket:[", 8) != 0)
+                continue;
+            inode = strtoul(link + 8, &end, 10);
+            if (*end != ']')
+                continue;
+            if (wanted != NULL) {
+                match = bsearch(&inode, wanted, nwanted,
+                                sizeof(unsigned long), psutil_cmp_inode);
+                if (match == NULL)
+                    continue;
+                if (! found[match - wanted]) {
+                    found[match - wanted] = 1;
+                    (*nfound)++;
+                }
+            }
+            if (*count == *capacity) {
+                *capacity *= 2;
+                tmp = realloc(*entries, *capacity * sizeof(psutil_sock_fd));
+                if (tmp == NULL)
+                    return ENOMEM;
+                *entries = tmp;
+            }
+            (*entries)[*count].inode = inode;
+            (*entries)[*count].pid = pid;
+            (*entries)[*count].fd = (int)strtol(dent->d_name, NULL, 10);
+            (*count)++;
+        }
+    }
+}
+
+
+/*
+ * Walk /proc/[pid]/fd of all processes and collect the socket fds.
+ * If "wanted" (a sorted array of inodes) is not NULL stop as soon as
+ * all of them are found. The GIL must be released by the caller.
+ * Processes we're not allowed to inspect or which disappear while
+ * scanning are skipped. Return 0 on success or an errno value.
+ */
+static int
+psutil_proc_fd_scan(const char *procfs_path, unsigned long *wanted,
+                    size_t nwanted, psutil_sock_fd **retentries,
+                    size_t *retcount) {
+    int dirfd = -1;
+    int fddir;
+    int nread;
+    int pos;
+    int err = 0;
+    char *dents = NULL;
+    char *fddents = NULL;
+    char *found = NULL;
+    char path[64];
+    size_t nfound = 0;
+    size_t count = 0;
+    size_t capacity = 1024;
+    struct psutil_dirent64 *dent;
+    psutil_sock_fd *entries = NULL;
+
+    dents = malloc(PSUTIL_DENTS_BUFSIZE);
+    fddents = malloc(PSUTIL_DENTS_BUFSIZE);
+    found = calloc(nwanted + 1, 1);
+    entries = malloc(capacity * sizeof(psutil_sock_fd));
+    if (dents == NULL || fddents == NULL || found == NULL ||
+            entries == NULL) {
+        err = ENOMEM;
+        goto done;
+    }
+
+    dirfd = open(procfs_path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd == -1) {
+        err = errno;
+        goto done;
+    }
+    while (err == 0) {
+        if (wanted != NULL && nfound == nwanted)
+            break;
+        nread = psutil_getdents64(dirfd, dents, PSUTIL_DENTS_BUFSIZE);
+        if (nread == -1) {
+            err = errno;
+            break;
+        }
+        if (nread == 0)
+            break;
+        for (pos = 0; pos < nread; pos += dent->d_reclen) {
+            dent = (struct psutil_dirent64 *)(dents + pos);
+            if (! psutil_is_pid_name(dent->d_name))
+                continue;
+            snprintf(path, sizeof(path), "%s/fd", dent->d_name);
+            fddir = openat(dirfd, path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+            if (fddir == -1) {
+                // EACCES / EPERM == not our process (same as "lsof"
+                // and "netstat" we just skip it), ENOENT / ESRCH ==
+                // the process is gone.
+                if (errno == EACCES || errno == EPERM ||
+                        errno == ENOENT || errno == ESRCH)
+                    continue;
+                err = errno;
+                break;
+            }
+            err = psutil_proc_fd_scan_pid(
+                fddir, strtol(dent->d_name, NULL, 10), fddents,
+                wanted, nwanted, found, &nfound, &entries, &count,
+                &capacity);
+            close(fddir);
+            if (err == ENOENT || err == ESRCH || err == EACCES)
+                err = 0;
+            if (err != 0)
+                break;
+            // all the fds of this process were collected
+            if (wanted != NULL && nfound == nwanted)
+                break;
+        }
+    }
+
+done:
+    if (dirfd != -1)
+        close(dirfd);
+    free(dents);
+    free(fddents);
+    free(found);
+    if (err != 0) {
+        free(entries);
+        return err;
+    }
+    *retentries = entries;
+    *retcount = count;
+    return 0;
+}
+
+
+/*
+ * Return a {inode: [(pid, fd), ...]} dict of the sockets opened by all
+ * processes, where inode is a string (as in /proc/net files). If a
+ * socket is shared by more processes only the fds of the first one
+ * are listed. If a sequence of "wanted" inodes is passed, other
+ * sockets are ignored and /proc is walked until all of them are
+ * found.
+ */
+PyObject *
+psutil_proc_socket_inodes(PyObject *self, PyObject *args) {
+    char *procfs_path;
+    char key[32];
+    int err;
+    size_t i;
+    size_t count = 0;
+    size_t nwanted = 0;
+    unsigned long *wanted = NULL;
+    psutil_sock_fd *entries = NULL;
+    PyObject *py_wanted = Py_None;
+    PyObject *py_seq = NULL;
+    PyObject *py_list = NULL;
+    PyObject *py_first;
+    PyObject *py_tuple = NULL;
+    PyObject *py_retdict = NULL;
+
+    if (! PyArg_ParseTuple(args, "s|O", &procfs_path, &py_wanted))
+        return NULL;
+    if (py_wanted != Py_None) {
+        py_seq = PySequence_Fast(py_wanted, "wanted must be a sequence");
+        if (py_seq == NULL)
+            return NULL;
+        nwanted = (size_t)PySequence_Fast_GET_SIZE(py_seq);
+        wanted = malloc((nwanted + 1) * sizeof(unsigned long));
+        if (wanted == NULL) {
+            PyErr_NoMemory();
+            goto error;
+        }
+        for (i = 0; i < nwanted; i++) {
+            wanted[i] = PyLong_AsUnsignedLong(
+                PySequence_Fast_GET_ITEM(py_seq, i));
+            if (wanted[i] == (unsigned long)-1 && PyErr_Occurred())
+                goto error;
+        }
+        qsort(wanted, nwanted, sizeof(unsigned long), psutil_cmp_inode);
+        Py_CLEAR(py_seq);
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    err = psutil_proc_fd_scan(procfs_path, wanted, nwanted, &entries,
+                              &count);
+    Py_END_ALLOW_THREADS
+    if (err != 0) {
+        psutil_proc_scan_seterr(err, procfs_path);
+        goto error;
+    }
+
+    py_retdict = PyDict_New();
+    if (py_retdict == NULL)
+        goto error;
+    for (i = 0; i < count; i++) {
+        snprintf(key, sizeof(key), "%lu", entries[i].inode);
+        py_list = PyDict_GetItemString(py_retdict, key);  // borrowed
+        if (py_list == NULL) {
+            py_list = PyList_New(0);
+            if (py_list == NULL)
+                goto error;
+            if (PyDict_SetItemString(py_retdict, key, py_list)) {
+                Py_DECREF(py_list);
+                goto error;
+            }
+            Py_DECREF(py_list);
+        }
+        else {
+            // shared with a process we already listed
+            py_first = PyList_GET_ITEM(py_list, 0);
+            if (PyLong_AsLong(PyTuple_GET_ITEM(py_first, 0)) !=
+                    entries[i].pid)
+                continue;
+        }
+        py_tuple = Py_BuildValue("(li)", entries[i].pid, entries[i].fd);
+        if (py_tuple == NULL)
+            goto error;
+        if (PyList_Append(py_list, py_tuple))
+            goto error;
+        Py_CLEAR(py_tuple);
+    }
+
+    free(wanted);
+    free(entries);
+    return py_retdict;
+
+error:
+    Py_XDECREF(py_seq);
+    Py_XDECREF(py_tuple);
+    Py_XDECREF(py_retdict);
+    free(wanted);
+    free(entries);
+    return NULL;
+}
+
+
+/*
+ * Open /proc/[pid] as an O_PATH directory fd plus the given files
+ * relative to it (e.g. "stat", "statm") and return a
+ * (dirfd, [fd, ...]) tuple. A file fd is -1 if we're not allowed to
+ * open it. The fds refer to the process they were opened for: once
+ * it's gone reading from them fails with ESRCH, even if the PID was
+ * reused in the meantime.
+ */
+PyObject *
+psutil_proc_watch_open(PyObject *self, PyObject *args) {
+    char *path;
+    const char *name;
+    int dirfd;
+    int *fds = NULL;
+    Py_ssize_t i;
+    Py_ssize_t n;
+    PyObject *py_names;
+    PyObject *py_fd = NULL;
+    PyObject *py_fds = NULL;
+
+    if (! PyArg_ParseTuple(args, "sO!", &path, &PyTuple_Type, &py_names))
+        return NULL;
+    n = PyTuple_GET_SIZE(py_names);
+    fds = malloc((n + 1) * sizeof(int));
+    if (fds == NULL)
+        return PyErr_NoMemory();
+    for (i = 0; i < n; i++)
+        fds[i] = -1;
+
+    dirfd = open(path, O_PATH | O_DIRECTORY | O_CLOEXEC);
+    if (dirfd == -1) {
+        PyErr_SetFromErrnoWithFilename(PyExc_OSError, path);
+        goto error;
+    }
+    for (i = 0; i < n; i++) {
+#if PY_MAJOR_VERSION >= 3
+        name = PyUnicode_AsUTF8(PyTuple_GET_ITEM(py_names, i));
+#else
+        name = PyString_AsString(PyTuple_GET_ITEM(py_names, i));
+#endif
+        if (name == NULL)
+            goto error;
+        fds[i] = openat(dirfd, name, O_RDONLY | O_CLOEXEC);
+        if (fds[i] == -1) {
+            if (errno == EACCES || errno == EPERM)
+                continue;
+            PyErr_SetFromErrnoWithFilename(PyExc_OSError, path);
+            goto error;
+        }
+    }
+
+    py_fds = PyList_New(n);
+    if (py_fds == NULL)
+        goto error;
+    for (i = 0; i < n; i++) {
+        py_fd = Py_BuildValue("i", fds[i]);
+        if (py_fd == NULL)
+            goto error;
+        PyList_SET_ITEM(py_fds, i, py_fd);
+    }
+    free(fds);
+    return Py_BuildValue("(iN)", dirfd, py_fds);
+
+error:
+    Py_XDECREF(py_fds);
+    for (i = 0; i < n; i++) {
+        if (fds[i] != -1)
+            close(fds[i]);
+    }
+    if (dirfd != -1)
+        close(dirfd);
+    free(fds);
+    return NULL;
+}
+
+
+/*
+ * Read the whole content of a /proc file from offset 0 via pread(2)
+ * so that the same fd can be read over and over without seeking or
+ * reopening it. Small files are read in a single syscall into a
+ * stack buffer.
+ */
+PyObject *
+psutil_proc_pread(PyObject *self, PyObject *args) {
+    int fd;
+    ssize_t ret;
+    size_t size = PSUTIL_PREAD_BUFSIZE;
+    char stackbuf[PSUTIL_PREAD_BUFSIZE];
+    char *buf = stackbuf;
+    char *tmp;
+    PyObject *py_ret;
+
+    if (! PyArg_ParseTuple(args, "i", &fd))
+        return NULL;
+
+    while (1) {
+        Py_BEGIN_ALLOW_THREADS
+        ret = pread(fd, buf, size, 0);
+        Py_END_ALLOW_THREADS
+        if (ret == -1) {
+            if (errno == EINTR)
+                continue;
+            PyErr_SetFromErrno(PyExc_OSError);
+            goto error;
+        }
+        if ((size_t)ret < size)
+            break;
+        // the buffer may be too small; try again with a bigger one
+        size *= 2;
+        tmp = buf == stackbuf ? malloc(size) : realloc(buf, size);
+        if (tmp == NULL) {
+            PyErr_NoMemory();
+            goto error;
+        }
+        buf = tmp;
+    }
+
+    py_ret = PyBytes_FromStringAndSize(buf, ret);
+    if (buf != stackbuf)
+        free(buf);
+    return py_ret;
+
+error:
+    if (buf != stackbuf)
+        free(buf);
+    return NULL;
+}
+
+
+/*
+ * Stream /proc/[pid]/smaps and return a (uss, pss, swap) tuple in
+ * bytes, obtained by summing the Private_*, Pss and Swap fields of
+ * all the mappings, without reading the whole file in memory.
+ */
+PyObject *
+psutil_proc_smaps_totals(PyObject *self, PyObject *args) {
+    char *path;
+    char line[PSUTIL_SMAPS_LINESIZE];
+    int bol = 1;  // at the beginning of a line
+    int err = 0;
+    unsigned long long uss = 0;
+    unsigned long long pss = 0;
+    unsigned long long swap = 0;
+    size_t len;
+    char *value;
+    FILE *file;
+
+    if (! PyArg_ParseTuple(args, "s", &path))
+        return NULL;
+
+    Py_BEGIN_ALLOW_THREADS
+    file = fopen(path, "re");
+    if (file == NULL) {
+        err = errno;
+    }
+    else {
+        while (fgets(line, sizeof(line), file) != NULL) {
+            // Lines longer than the buffer (e.g. mappings of files with
+            // long paths) are read in chunks: only look at the first.
+            if (bol) {
+                // Private_Clean, Private_Dirty, Private_Hugetlb
+                if (strncmp(line, "Private_", 8) == 0 &&
+                        (value = strchr(line, ':')) != NULL)
+                    uss += strtoull(value + 1, NULL, 10);
+                else if (strncmp(line, "Pss:", 4) == 0)
+                    pss += strtoull(line + 4, NULL, 10);
+                else if (strncmp(line, "Swap:", 5) == 0)
+                    swap += strtoull(line + 5, NULL, 10);
+            }
+            len = strlen(line);
+            bol = len > 0 && line[len - 1] == '\n';
+        }
+        if (ferror(file))
+            err = errno;
+        fclose(file);
+    }
+    Py_END_ALLOW_THREADS
+
+    if (err != 0) {
+        errno = err;
+        return PyErr_SetFromErrnoWithFilename(PyExc_OSError, path);
+    }
+    return Py_BuildValue(
+        "(KKK)", uss * 1024, pss * 1024, swap * 1024);
+}
+
+
+// A mapping (block) of /proc/[pid]/smaps being parsed. Strings point
+// into the data passed to psutil_proc_smaps_parse().
+typedef struct {
+    const char *addr;
+    size_t addr_len;
+    const char *perms;
+    size_t perms_len;
+    const char *path;
+    size_t path_len;
+    unsigned long long values[PSUTIL_SMAPS_NFIELDS];
+} psutil_smaps_block;
+
+// The fields returned for each mapping, in order.
+static const char *psutil_smaps_fields[PSUTIL_SMAPS_NFIELDS] = {
+    "Rss:", "Size:", "Pss:", "Shared_Clean:", "Shared_Dirty:",
+    "Private_Clean:", "Private_Dirty:", "Referenced:", "Anonymous:",
+    "Swap:"
+};
+
+
+/*
+ * Return the next whitespace separated token in [*pos, end) and its
+ * length, advancing *pos past it.
+ */
+static const char *
+psutil_next_token(const char **pos, const char *end, size_t *len) {
+    const char *start = *pos;
+
+    while (start < end && (*start == ' ' || *start == '\t'))
+        start++;
+    *pos = start;
+    while (*pos < end && **pos != ' ' && **pos != '\t')
+        (*pos)++;
+    *len = *pos - start;
+    return start;
+}
+
+
+/*
+ * Parse the header line of a mapping, as in:
+ * "00400000-0040b000 r-xp 00000000 08:01 1234   /bin/cat"
+ */
+static void
+psutil_smaps_parse_header(const char *line, const char *end,
+                          psutil_smaps_block *block) {
+    const char *pos = line;
+    size_t len;
+
+    memset(block, 0, sizeof(*block));
+    block->addr = psutil_next_token(&pos, end, &block->addr_len);
+    block->perms = psutil_next_token(&pos, end, &block->perms_len);
+    psutil_next_token(&pos, end, &len);  // offset
+    psutil_next_token(&pos, end, &len);  // dev
+    psutil_next_token(&pos, end, &len);  // inode
+    // The path is the rest of the line and may contain spaces.
+    while (pos < end && (*pos == ' ' || *pos == '\t'))
+        pos++;
+    while (end > pos && (end[-1] == ' ' || end[-1] == '\t'))
+        end--;
+    block->path = pos;
+    block->path_len = end - pos;
+}
+
+
+/*
+ * Parse a "Key:   value kB" line of a mapping.
+ */
+static void
+psutil_smaps_parse_field(const char *line, size_t len,
+                         psutil_smaps_block *block) {
+    int i;
+    size_t klen;
+
+    for (i = 0; i < PSUTIL_SMAPS_NFIELDS; i++) {
+        klen = strlen(psutil_smaps_fields[i]);
+        if (len > klen && memcmp(line, psutil_smaps_fields[i], klen) == 0) {
+            block->values[i] = strtoull(line + klen, NULL, 10) * 1024;
+            return;
+        }
+    }
+}
+
+
+/*
+ * Apply the filters to a parsed mapping and, if it matches, either
+ * append it to py_retlist as a tuple or add its values to the ones
+ * of its path in py_groups (if not None).
+ * Return 0 on success, -1 (with an exception set) on error.
+ */
+static int
+psutil_smaps_emit(psutil_smaps_block *block, const char *path_filter,
+                  const char *perms_filter, PyObject *py_groups,
+                  PyObject *py_retlist) {
+    int i;
+    int ret = -1;
+    size_t path_len = block->path_len;
+    const char *perm;
+    char *path = NULL;
+    struct stat st;
+    unsigned long long sum;
+    PyObject *py_path = NULL;
+    PyObject *py_value = NULL;
+    PyObject *py_values;
+    PyObject *py_tuple;
+
+    if (perms_filter != NULL) {
+        for (perm = perms_filter; *perm != '\0'; perm++) {
+            if (*perm != '-' &&
+                    memchr(block->perms, *perm, block->perms_len) == NULL)
+                return 0;
+        }
+    }
+
+    if (path_len == 0) {
+        path = strdup("[anon]");
+        path_len = 6;
+    }
+    else {
+        path = malloc(path_len + 1);
+        if (path != NULL) {
+            memcpy(path, block->path, path_len);
+            path[path_len] = '\0';
+        }
+    }
+    if (path == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    // Strip the " (deleted)" suffix unless the file actually has a
+    // name like that.
+    if (path_len > 10 && strcmp(path + path_len - 10, " (deleted)") == 0 &&
+            stat(path, &st) == -1 && errno != EACCES && errno != EPERM) {
+        path_len -= 10;
+        path[path_len] = '\0';
+    }
+    if (path_filter != NULL && fnmatch(path_filter, path, 0) != 0) {
+        ret = 0;
+        goto exit;
+    }
+
+#if PY_MAJOR_VERSION >= 3
+    py_path = PyUnicode_DecodeFSDefaultAndSize(path, path_len);
+#else
+    py_path = PyString_FromStringAndSize(path, path_len);
+#endif
+    if (py_path == NULL)
+        goto exit;
+
+    if (py_groups != Py_None) {
+        py_values = PyDict_GetItem(py_groups, py_path);  // borrowed
+        if (py_values == NULL) {
+            py_values = PyList_New(PSUTIL_SMAPS_NFIELDS);
+            if (py_values == NULL)
+                goto exit;
+            for (i = 0; i < PSUTIL_SMAPS_NFIELDS; i++) {
+                py_value = PyLong_FromUnsignedLongLong(block->values[i]);
+                if (py_value == NULL) {
+                    Py_DECREF(py_values);
+                    goto exit;
+                }
+                PyList_SET_ITEM(py_values, i, py_value);
+            }
+            i = PyDict_SetItem(py_groups, py_path, py_values);
+            Py_DECREF(py_values);
+            if (i != 0)
+                goto exit;
+        }
+        else {
+            for (i = 0; i < PSUTIL_SMAPS_NFIELDS; i++) {
+                sum = PyLong_AsUnsignedLongLong(
+                    PyList_GET_ITEM(py_values, i));
+                if (sum == (unsigned long long)-1 && PyErr_Occurred())
+                    goto exit;
+                py_value = PyLong_FromUnsignedLongLong(
+                    sum + block->values[i]);
+                if (py_value == NULL)
+                    goto exit;
+                // steals the reference
+                PyList_SetItem(py_values, i, py_value);
+            }
+        }
+        ret = 0;
+        goto exit;
+    }
+
+    py_tuple = Py_BuildValue(
+        "(s#s#OKKKKKKKKKK)",
+        block->addr, (Py_ssize_t)block->addr_len,
+        block->perms, (Py_ssize_t)block->perms_len,
+        py_path,
+        block->values[0], block->values[1], block->values[2],
+        block->values[3], block->values[4], block->values[5],
+        block->values[6], block->values[7], block->values[8],
+        block->values[9]);
+    if (py_tuple == NULL)
+        goto exit;
+    ret = PyList_Append(py_retlist, py_tuple);
+    Py_DECREF(py_tuple);
+
+exit:
+    Py_XDECREF(py_path);
+    free(path);
+    return ret;
+}
+
+
+/*
+ * Parse a chunk of /proc/[pid]/smaps content and return a
+ * (consumed, [(addr, perms, path, rss, size, pss, shared_clean,
+ * shared_dirty, private_clean, private_dirty, referenced, anonymous,
+ * swap), ...]) tuple. Only complete mappings are parsed: the caller is
+ * supposed to pass data[consumed:] again, followed by the next chunk.
+ * "final" means there's no more data to come.
+ * Mappings whose path does not match "path_filter" (a shell-style
+ * wildcard pattern) or lacking any of the permissions in "perms" are
+ * skipped without creating Python objects. If "groups" is a dict,
+ * the values of the mappings are added to those of their path in it
+ * (as a list) and no tuples are returned.
+ */
+PyObject *
+psutil_proc_smaps_parse(PyObject *self, PyObject *args) {
+    const char *data;
+    const char *end;
+    const char *pos;
+    const char *eol;
+    const char *tok_end;
+    const char *path_filter;
+    const char *perms_filter;
+    Py_ssize_t size;
+    Py_ssize_t consumed = 0;
+    int final;
+    int in_block = 0;
+    psutil_smaps_block block;
+    PyObject *py_groups;
+    PyObject *py_retlist = NULL;
+
+    if (! PyArg_ParseTuple(args, PSUTIL_SMAPS_PARSE_ARGS,
+                           &data, &size, &final, &path_filter,
+                           &perms_filter, &py_groups))
+        return NULL;
+    if (py_groups != Py_None && ! PyDict_Check(py_groups)) {
+        PyErr_SetString(PyExc_TypeError, "groups must be a dict or None");
+        return NULL;
+    }
+    py_retlist = PyList_New(0);
+    if (py_retlist == NULL)
+        return NULL;
+
+    end = data + size;
+    pos = data;
+    while (pos < end) {
+        eol = memchr(pos, '\n', end - pos);
+        if (eol == NULL) {
+            if (! final)
+                break;  // incomplete line
+            eol = end;
+        }
+        // A header line's first token does not end with ':'.
+        tok_end = pos;
+        while (tok_end < eol && *tok_end != ' ' && *tok_end != '\t')
+            tok_end++;
+        if (tok_end > pos && tok_end[-1] != ':') {
+            if (in_block) {
+                if (psutil_smaps_emit(&block, path_filter, perms_filter,
+                                      py_groups, py_retlist) != 0)
+                    goto error;
+            }
+            psutil_smaps_parse_header(pos, eol, &block);
+            in_block = 1;
+            consumed = pos - data;
+        }
+        else if (in_block) {
+            psutil_smaps_parse_field(pos, eol - pos, &block);
+        }
+        pos = eol + 1;
+    }
+
+    if (final) {
+        if (in_block) {
+            if (psutil_smaps_emit(&block, path_filter, perms_filter,
+                                  py_groups, py_retlist) != 0)
+                goto error;
+        }
+        consumed = size;
+    }
+    else if (! in_block) {
+        // no mapping started yet
+        consumed = pos - data;
+    }
+
+    return Py_BuildValue("(nN)", consumed, py_retlist);
+
+error:
+    Py_DECREF(py_retlist);
+    return NULL;
+}
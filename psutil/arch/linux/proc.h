@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <Python.h>
+#include <stdint.h>
+
+// Same layout as the kernel's struct linux_dirent64. glibc < 2.30 does
+// not expose getdents64() so we define it here and use syscall(2).
+struct psutil_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+int psutil_getdents64(int fd, char *buf, size_t size);
+int psutil_is_pid_name(const char *name);
+
+PyObject* psutil_proc_stat_scan(PyObject* self, PyObject* args);
+PyObject* psutil_proc_counters_scan(PyObject* self, PyObject* args);
+PyObject* psutil_proc_socket_inodes(PyObject* self, PyObject* args);
+PyObject* psutil_proc_watch_open(PyObject* self, PyObject* args);
+PyObject* psutil_proc_pread(PyObject* self, PyObject* args);
+PyObject* psutil_proc_smaps_totals(PyObject* self, PyObject* args);
+PyObject* psutil_proc_smaps_parse(PyObject* self, PyObject* args);
@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Process events (fork / exit) notified by the kernel proc connector
+ * over a NETLINK_CONNECTOR socket. Requires CAP_NET_ADMIN.
+ */
+
+#include <Python.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+
+#include "../../_psutil_common.h"
+#include "proc_events.h"
+
+// Receive buffer size requested for the socket, so that bursts of
+// events occurring between two reads are not lost.
+#define PSUTIL_PROC_EVENTS_RCVBUF (4 * 1024 * 1024)
+#define PSUTIL_PROC_EVENTS_BUFSIZE 8192
+
+
+/*
+ * Open a netlink socket subscribed to process events and return its
+ * file descriptor, which is non-blocking.
+ */
+PyObject *
+psutil_proc_events_open(PyObject *self, PyObject *args) {
+    int sock;
+    int bufsize = PSUTIL_PROC_EVENTS_RCVBUF;
+    char buf[NLMSG_SPACE(sizeof(struct cn_msg) +
+                         sizeof(enum proc_cn_mcast_op))];
+    struct sockaddr_nl addr;
+    struct nlmsghdr *nlh;
+    struct cn_msg *msg;
+    enum proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+
+    sock = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                  NETLINK_CONNECTOR);
+    if (sock == -1)
+        return PyErr_SetFromOSErrnoWithSyscall("socket(NETLINK_CONNECTOR)");
+
+    // SO_RCVBUFFORCE ignores the rmem_max limit but requires
+    // CAP_NET_ADMIN, which we need anyway. Not fatal.
+    if (setsockopt(sock, SOL_SOCKET, SO_RCVBUFFORCE, &bufsize,
+                   sizeof(bufsize)) == -1) {
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof(bufsize));
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.nl_family = AF_NETLINK;
+    addr.nl_groups = CN_IDX_PROC;
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) == -1) {
+        PyErr_SetFromOSErrnoWithSyscall("bind(CN_IDX_PROC)");
+        goto error;
+    }
+
+    memset(buf, 0, sizeof(buf));
+    nlh = (struct nlmsghdr *)buf;
+    nlh->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(op));
+    nlh->nlmsg_type = NLMSG_DONE;
+    msg = (struct cn_msg *)NLMSG_DATA(nlh);
+    msg->id.idx = CN_IDX_PROC;
+    msg->id.val = CN_VAL_PROC;
+    msg->len = sizeof(op);
+    memcpy(msg->data, &op, sizeof(op));
+    if (send(sock, nlh, nlh->nlmsg_len, 0) == -1) {
+        PyErr_SetFromOSErrnoWithSyscall("send(PROC_CN_MCAST_LISTEN)");
+        goto error;
+    }
+
+    return Py_BuildValue("i", sock);
+
+error:
+    close(sock);
+    return NULL;
+}
+
+
+/*
+ * Read all the events queued on the socket returned by
+ * psutil_proc_events_open() and return them as a list of
+ * (event, pid) tuples, in the order they occurred. Threads are
+ * ignored. Raise OSError(ENOBUFS) if events were lost because the
+ * socket buffer was full.
+ */
+PyObject *
+psutil_proc_events_read(PyObject *self, PyObject *args) {
+    int sock;
+    int len;
+    int event;
+    long pid;
+    char buf[PSUTIL_PROC_EVENTS_BUFSIZE]
+        __attribute__ ((aligned(NLMSG_ALIGNTO)));
+    struct nlmsghdr *nlh;
+    struct cn_msg *msg;
+    struct proc_event *ev;
+    PyObject *py_tuple = NULL;
+    PyObject *py_retlist = PyList_New(0);
+
+    if (py_retlist == NULL)
+        return NULL;
+    if (! PyArg_ParseTuple(args, "i", &sock))
+        goto error;
+
+    while (1) {
+        Py_BEGIN_ALLOW_THREADS
+        len = recv(sock, buf, sizeof(buf), 0);
+        Py_END_ALLOW_THREADS
+        if (len == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+            PyErr_SetFromErrno(PyExc_OSError);
+            goto error;
+        }
+        if (len == 0)
+            break;
+
+        for (nlh = (struct nlmsghdr *)buf;
+                NLMSG_OK(nlh, (unsigned int)len);
+                nlh = NLMSG_NEXT(nlh, len)) {
+            if (nlh->nlmsg_type != NLMSG_DONE)
+                continue;
+            msg = (struct cn_msg *)NLMSG_DATA(nlh);
+            if (msg->id.idx != CN_IDX_PROC || msg->id.val != CN_VAL_PROC)
+                continue;
+            ev = (struct proc_event *)msg->data;
+            switch (ev->what) {
+                case PROC_EVENT_FORK:
+                    if (ev->event_data.fork.child_pid !=
+                            ev->event_data.fork.child_tgid)
+                        continue;
+                    event = PSUTIL_PROC_EVENT_FORK;
+                    pid = ev->event_data.fork.child_tgid;
+                    break;
+                case PROC_EVENT_EXIT:
+                    if (ev->event_data.exit.process_pid !=
+                            ev->event_data.exit.process_tgid)
+                        continue;
+                    event = PSUTIL_PROC_EVENT_EXIT;
+                    pid = ev->event_data.exit.process_tgid;
+                    break;
+                default:
+                    continue;
+            }
+            py_tuple = Py_BuildValue("(il)", event, pid);
+            if (py_tuple == NULL)
+                goto error;
+            if (PyList_Append(py_retlist, py_tuple))
+                goto error;
+            Py_CLEAR(py_tuple);
+        }
+    }
+
+    return py_retlist;
+
+error:
+    Py_XDECREF(py_tuple);
+    Py_DECREF(py_retlist);
+    return NULL;
+}
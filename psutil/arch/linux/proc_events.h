@@ -0,0 +1,15 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <Python.h>
+
+// Values of the "event" field of the tuples returned by
+// psutil_proc_events_read().
+#define PSUTIL_PROC_EVENT_FORK 1
+#define PSUTIL_PROC_EVENT_EXIT 2
+
+PyObject* psutil_proc_events_open(PyObject* self, PyObject* args);
+PyObject* psutil_proc_events_read(PyObject* self, PyObject* args);
@@ -0,0 +1,756 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Network interfaces info via NETLINK_ROUTE (the interface used by
+ * "ip"), which returns all the links in one dump instead of requiring
+ * a file read or a bunch of ioctl()s per interface.
+ */
+
+#include <Python.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <linux/sockios.h>
+#include <linux/if.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/if_link.h>
+#include <linux/if_addr.h>
+
+// see: https://github.com/giampaolo/psutil/issues/659
+#ifdef PSUTIL_ETHTOOL_MISSING_TYPES
+    #include <linux/types.h>
+    typedef __u64 u64;
+    typedef __u32 u32;
+    typedef __u16 u16;
+    typedef __u8 u8;
+#endif
+#include <linux/ethtool.h>
+
+#include "../../_psutil_common.h"
+#include "netlink.h"
+#include "rtnetlink.h"
+
+
+// Argument of psutil_net_if_stats_append().
+typedef struct {
+    PyObject *py_retdict;
+    PyObject *py_nics;
+    int sock;
+} psutil_net_if_stats_ctx;
+
+// A link as seen by psutil_net_if_addrs().
+typedef struct {
+    int index;
+    unsigned int flags;
+    char name[IFNAMSIZ];
+} psutil_rtnl_link;
+
+// Argument of psutil_net_if_addrs_link() and psutil_net_if_addrs_addr().
+typedef struct {
+    PyObject *py_retlist;
+    PyObject *py_nics;
+    int want_link;
+    int want_inet;
+    int want_inet6;
+    psutil_rtnl_link *links;
+    size_t nlinks;
+    size_t size;
+} psutil_net_if_addrs_ctx;
+
+
+/*
+ * Fill "tb" (an array of IFLA_MAX + 1 elements) with the attributes of
+ * a RTM_NEWLINK message, indexed by type. Missing ones are NULL.
+ * Return the struct ifinfomsg of the message.
+ */
+static struct ifinfomsg *
+psutil_rtnl_parse_link(struct nlmsghdr *nlh, struct rtattr **tb) {
+    int attrlen;
+    struct ifinfomsg *ifi = (struct ifinfomsg *)NLMSG_DATA(nlh);
+    struct rtattr *attr;
+
+    memset(tb, 0, sizeof(struct rtattr *) * (IFLA_MAX + 1));
+    attrlen = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*ifi));
+    for (attr = IFLA_RTA(ifi); RTA_OK(attr, attrlen);
+            attr = RTA_NEXT(attr, attrlen)) {
+        if (attr->rta_type <= IFLA_MAX)
+            tb[attr->rta_type] = attr;
+    }
+    return ifi;
+}
+
+
+/*
+ * Copy the payload of a struct attribute into "dst", which is zeroed
+ * first as older kernels may send a shorter struct. The payload is
+ * only 4-bytes aligned so it can't be accessed in place.
+ */
+static void
+psutil_rtnl_copy(void *dst, size_t size, struct rtattr *attr) {
+    size_t len = RTA_PAYLOAD(attr);
+
+    memset(dst, 0, size);
+    memcpy(dst, RTA_DATA(attr), len < size ? len : size);
+}
+
+
+/*
+ * Callback for psutil_net_io_counters(): add a
+ * {name: (bytes_sent, bytes_recv, packets_sent, packets_recv, errin,
+ * errout, dropin, dropout, multicast, fifoin, fifoout, framein,
+ * carrierout, collisions, compressedin, compressedout)} entry to the
+ * dict. Error counters are summed up the same way /proc/net/dev does.
+ */
+static int
+psutil_net_io_counters_append(struct nlmsghdr *nlh, void *arg) {
+    PyObject *py_retdict = (PyObject *)arg;
+    PyObject *py_name = NULL;
+    PyObject *py_tuple = NULL;
+    struct rtattr *tb[IFLA_MAX + 1];
+    struct rtnl_link_stats64 st;
+    struct rtnl_link_stats st32;
+
+    if (nlh->nlmsg_type != RTM_NEWLINK)
+        return 0;
+    psutil_rtnl_parse_link(nlh, tb);
+    if (tb[IFLA_IFNAME] == NULL)
+        return 0;
+    if (tb[IFLA_STATS64] != NULL) {
+        psutil_rtnl_copy(&st, sizeof(st), tb[IFLA_STATS64]);
+    }
+    else if (tb[IFLA_STATS] != NULL) {
+        // Kernels < 2.6.35.
+        psutil_rtnl_copy(&st32, sizeof(st32), tb[IFLA_STATS]);
+        st.rx_packets = st32.rx_packets;
+        st.tx_packets = st32.tx_packets;
+        st.rx_bytes = st32.rx_bytes;
+        st.tx_bytes = st32.tx_bytes;
+        st.rx_errors = st32.rx_errors;
+        st.tx_errors = st32.tx_errors;
+        st.rx_dropped = st32.rx_dropped;
+        st.tx_dropped = st32.tx_dropped;
+        st.multicast = st32.multicast;
+        st.collisions = st32.collisions;
+        st.rx_length_errors = st32.rx_length_errors;
+        st.rx_over_errors = st32.rx_over_errors;
+        st.rx_crc_errors = st32.rx_crc_errors;
+        st.rx_frame_errors = st32.rx_frame_errors;
+        st.rx_fifo_errors = st32.rx_fifo_errors;
+        st.rx_missed_errors = st32.rx_missed_errors;
+        st.tx_aborted_errors = st32.tx_aborted_errors;
+        st.tx_carrier_errors = st32.tx_carrier_errors;
+        st.tx_fifo_errors = st32.tx_fifo_errors;
+        st.tx_heartbeat_errors = st32.tx_heartbeat_errors;
+        st.tx_window_errors = st32.tx_window_errors;
+        st.rx_compressed = st32.rx_compressed;
+        st.tx_compressed = st32.tx_compressed;
+    }
+    else {
+        return 0;
+    }
+
+    py_tuple = Py_BuildValue(
+        "(KKKKKKKKKKKKKKKK)",
+        (unsigned long long)st.tx_bytes,
+        (unsigned long long)st.rx_bytes,
+        (unsigned long long)st.tx_packets,
+        (unsigned long long)st.rx_packets,
+        (unsigned long long)st.rx_errors,
+        (unsigned long long)st.tx_errors,
+        (unsigned long long)(st.rx_dropped + st.rx_missed_errors),
+        (unsigned long long)st.tx_dropped,
+        (unsigned long long)st.multicast,
+        (unsigned long long)st.rx_fifo_errors,
+        (unsigned long long)st.tx_fifo_errors,
+        (unsigned long long)(st.rx_length_errors + st.rx_over_errors +
+                             st.rx_crc_errors + st.rx_frame_errors),
+        (unsigned long long)(st.tx_carrier_errors + st.tx_aborted_errors +
+                             st.tx_window_errors + st.tx_heartbeat_errors),
+        (unsigned long long)st.collisions,
+        (unsigned long long)st.rx_compressed,
+        (unsigned long long)st.tx_compressed);
+    if (py_tuple == NULL)
+        return -1;
+    // NIC names are not necessarily UTF-8.
+    py_name = PyUnicode_DecodeFSDefault((char *)RTA_DATA(tb[IFLA_IFNAME]));
+    if (py_name == NULL)
+        goto error;
+    if (PyDict_SetItem(py_retdict, py_name, py_tuple) != 0)
+        goto error;
+    Py_DECREF(py_name);
+    Py_DECREF(py_tuple);
+    return 0;
+
+error:
+    Py_XDECREF(py_name);
+    Py_DECREF(py_tuple);
+    return -1;
+}
+
+
+/*
+ * Return the I/O counters of all network interfaces as a dict, by
+ * dumping the 64-bit stats (IFLA_STATS64) of all links with a single
+ * RTM_GETLINK request. An optional network namespace fd can be passed,
+ * see psutil_netlink_dump().
+ */
+PyObject *
+psutil_net_io_counters(PyObject *self, PyObject *args) {
+    int netns_fd = -1;
+    PyObject *py_retdict;
+    struct {
+        struct nlmsghdr nlh;
+        struct ifinfomsg ifi;
+    } req;
+
+    if (! PyArg_ParseTuple(args, "|i", &netns_fd))
+        return NULL;
+    py_retdict = PyDict_New();
+    if (py_retdict == NULL)
+        return NULL;
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_type = RTM_GETLINK;
+    req.ifi.ifi_family = AF_UNSPEC;
+    if (psutil_netlink_dump(NETLINK_ROUTE, netns_fd, &req, sizeof(req),
+                            psutil_net_io_counters_append,
+                            py_retdict) != 0) {
+        Py_DECREF(py_retdict);
+        return NULL;
+    }
+    return py_retdict;
+}
+
+
+/*
+ * Get duplex and speed of a NIC via SIOCETHTOOL, using "sock" (an
+ * AF_INET socket) for the ioctl(). NICs not supporting it (e.g. wi-fi
+ * cards) get DUPLEX_UNKNOWN and 0.
+ * Return 0 on success, else -1 with errno set.
+ */
+int
+psutil_ethtool_duplex_speed(int sock, const char *nic_name, int *duplex,
+                            int *speed) {
+    struct ifreq ifr;
+    struct ethtool_cmd ethcmd;
+
+    memset(&ifr, 0, sizeof(ifr));
+    strncpy(ifr.ifr_name, nic_name, sizeof(ifr.ifr_name) - 1);
+    memset(&ethcmd, 0, sizeof ethcmd);
+    ethcmd.cmd = ETHTOOL_GSET;
+    ifr.ifr_data = (void *)&ethcmd;
+    if (ioctl(sock, SIOCETHTOOL, &ifr) != -1) {
+        *duplex = ethcmd.duplex;
+        *speed = ethcmd.speed;
+        return 0;
+    }
+    if ((errno == EOPNOTSUPP) || (errno == EINVAL)) {
+        // EOPNOTSUPP may occur in case of wi-fi cards.
+        // For EINVAL see:
+        // https://github.com/giampaolo/psutil/issues/797
+        //     #issuecomment-202999532
+        *duplex = DUPLEX_UNKNOWN;
+        *speed = 0;
+        return 0;
+    }
+    return -1;
+}
+
+
+/*
+ * Callback for psutil_net_if_stats(): add a
+ * {name: (isup, duplex, speed, mtu)} entry to the dict. SIOCETHTOOL is
+ * queried for all links but loopback, which has no speed. Links with no
+ * carrier are queried as well, as drivers may still report a speed.
+ */
+static int
+psutil_net_if_stats_append(struct nlmsghdr *nlh, void *arg) {
+    int ret;
+    int mtu = 0;
+    int duplex = DUPLEX_UNKNOWN;
+    int speed = 0;
+    const char *name;
+    psutil_net_if_stats_ctx *ctx = (psutil_net_if_stats_ctx *)arg;
+    struct rtattr *tb[IFLA_MAX + 1];
+    struct ifinfomsg *ifi;
+    PyObject *py_name = NULL;
+    PyObject *py_tuple = NULL;
+
+    if (nlh->nlmsg_type != RTM_NEWLINK)
+        return 0;
+    ifi = psutil_rtnl_parse_link(nlh, tb);
+    if (tb[IFLA_IFNAME] == NULL)
+        return 0;
+    name = (const char *)RTA_DATA(tb[IFLA_IFNAME]);
+    // NIC names are not necessarily UTF-8.
+    py_name = PyUnicode_DecodeFSDefault((char *)name);
+    if (py_name == NULL)
+        return -1;
+    if (ctx->py_nics != Py_None) {
+        ret = PySequence_Contains(ctx->py_nics, py_name);
+        if (ret != 1) {
+            Py_DECREF(py_name);
+            return ret;  // 0 (not wanted) or -1 (error)
+        }
+    }
+
+    if (tb[IFLA_MTU] != NULL)
+        mtu = *(unsigned int *)RTA_DATA(tb[IFLA_MTU]);
+    if (! (ifi->ifi_flags & IFF_LOOPBACK)) {
+        if (ctx->sock == -1) {
+            ctx->sock = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+            if (ctx->sock == -1) {
+                PyErr_SetFromOSErrnoWithSyscall("socket()");
+                goto error;
+            }
+        }
+        if (psutil_ethtool_duplex_speed(ctx->sock, name, &duplex,
+                                        &speed) != 0) {
+            // The NIC disappeared in the meantime.
+            if (errno == ENODEV) {
+                Py_DECREF(py_name);
+                return 0;
+            }
+            PyErr_SetFromOSErrnoWithSyscall("ioctl(SIOCETHTOOL)");
+            goto error;
+        }
+    }
+
+    py_tuple = Py_BuildValue(
+        "(Oiii)",
+        (ifi->ifi_flags & IFF_UP) ? Py_True : Py_False,
+        duplex,
+        speed,
+        mtu);
+    if (py_tuple == NULL)
+        goto error;
+    if (PyDict_SetItem(ctx->py_retdict, py_name, py_tuple) != 0)
+        goto error;
+    Py_DECREF(py_name);
+    Py_DECREF(py_tuple);
+    return 0;
+
+error:
+    Py_DECREF(py_name);
+    Py_XDECREF(py_tuple);
+    return -1;
+}
+
+
+/*
+ * Return {name: (isup, duplex, speed, mtu)} for all the NICs, or only
+ * for the ones whose name is in the "nics" container if it's not None.
+ * Flags and MTU of all the links come from a single RTM_GETLINK dump
+ * instead of one socket and 3 ioctl()s per NIC; duplex and speed still
+ * need one SIOCETHTOOL ioctl() per link (but loopback).
+ */
+PyObject *
+psutil_net_if_stats(PyObject *self, PyObject *args) {
+    int ret;
+    psutil_net_if_stats_ctx ctx;
+    struct {
+        struct nlmsghdr nlh;
+        struct ifinfomsg ifi;
+    } req;
+
+    ctx.py_nics = Py_None;
+    if (! PyArg_ParseTuple(args, "|O", &ctx.py_nics))
+        return NULL;
+    ctx.py_retdict = PyDict_New();
+    if (ctx.py_retdict == NULL)
+        return NULL;
+    ctx.sock = -1;
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_type = RTM_GETLINK;
+    req.ifi.ifi_family = AF_UNSPEC;
+    ret = psutil_netlink_dump(NETLINK_ROUTE, -1, &req, sizeof(req),
+                              psutil_net_if_stats_append, &ctx);
+    if (ctx.sock != -1)
+        close(ctx.sock);
+    if (ret != 0) {
+        Py_DECREF(ctx.py_retdict);
+        return NULL;
+    }
+    return ctx.py_retdict;
+}
+
+
+/*
+ * Return 1 if a NIC is in the "nics" container (or if it's None), 0 if
+ * not, -1 on error. On success *py_name is a new reference to the name.
+ */
+static int
+psutil_rtnl_nic_wanted(PyObject *py_nics, const char *name,
+                       PyObject **py_name) {
+    int ret;
+
+    // NIC names are not necessarily UTF-8.
+    *py_name = PyUnicode_DecodeFSDefault((char *)name);
+    if (*py_name == NULL)
+        return -1;
+    if (py_nics == Py_None)
+        return 1;
+    ret = PySequence_Contains(py_nics, *py_name);
+    if (ret != 1)
+        Py_CLEAR(*py_name);
+    return ret;
+}
+
+
+/*
+ * Return 1 if "family" is in the "families" container (or if it's
+ * None), 0 if not, -1 on error.
+ */
+static int
+psutil_rtnl_family_wanted(PyObject *py_families, int family) {
+    int ret;
+    PyObject *py_family;
+
+    if (py_families == Py_None)
+        return 1;
+    py_family = Py_BuildValue("i", family);
+    if (py_family == NULL)
+        return -1;
+    ret = PySequence_Contains(py_families, py_family);
+    Py_DECREF(py_family);
+    return ret;
+}
+
+
+/*
+ * Turn a link layer (MAC) address attribute into a
+ * "xx:xx:xx:xx:xx:xx" string. Return None if the attribute is NULL or
+ * empty.
+ */
+static PyObject *
+psutil_rtnl_lladdr(struct rtattr *attr) {
+    char buf[128];
+    char *ptr = buf;
+    size_t n;
+    size_t len;
+    const unsigned char *data;
+
+    if (attr == NULL || RTA_PAYLOAD(attr) == 0)
+        Py_RETURN_NONE;
+    len = RTA_PAYLOAD(attr);
+    if (len > sizeof(buf) / 3)
+        len = sizeof(buf) / 3;
+    data = (const unsigned char *)RTA_DATA(attr);
+    for (n = 0; n < len; ++n) {
+        sprintf(ptr, "%02x:", data[n]);
+        ptr += 3;
+    }
+    *--ptr = '\0';
+    return Py_BuildValue("s", buf);
+}
+
+
+/*
+ * Turn an IPv4 / IPv6 address into a string. IPv6 link-local addresses
+ * are suffixed with "%" + the NIC name, as getnameinfo() does.
+ * Return None if "src" is NULL.
+ */
+static PyObject *
+psutil_rtnl_inaddr(int family, const void *src, const char *ifname) {
+    char buf[INET6_ADDRSTRLEN + IFNAMSIZ + 1];
+    const struct in6_addr *addr6 = (const struct in6_addr *)src;
+
+    if (src == NULL)
+        Py_RETURN_NONE;
+    if (inet_ntop(family, src, buf, INET6_ADDRSTRLEN) == NULL)
+        return PyErr_SetFromErrno(PyExc_OSError);
+    if (family == AF_INET6 &&
+            (IN6_IS_ADDR_LINKLOCAL(addr6) || IN6_IS_ADDR_MC_LINKLOCAL(addr6)))
+    {
+        strcat(buf, "%");
+        strcat(buf, ifname);
+        return PyUnicode_DecodeFSDefault(buf);
+    }
+    return Py_BuildValue("s", buf);
+}
+
+
+/*
+ * Turn a prefix length into a netmask string.
+ */
+static PyObject *
+psutil_rtnl_netmask(int family, unsigned int prefixlen) {
+    unsigned char mask[16];
+    unsigned int i;
+
+    memset(mask, 0, sizeof(mask));
+    for (i = 0; i < prefixlen && i < sizeof(mask) * 8; i++)
+        mask[i / 8] |= 0x80 >> (i % 8);
+    return psutil_rtnl_inaddr(family, mask, "");
+}
+
+
+/*
+ * Append a (name, family, address, netmask, broadcast, ptp) tuple to
+ * the list. Broadcast or point-to-point address are set depending on
+ * the link flags, as psutil_net_if_addrs() in _psutil_posix.c does.
+ * Steals the references to all the objects, which must not be NULL.
+ */
+static int
+psutil_rtnl_addrs_append(PyObject *py_retlist, unsigned int flags,
+                         PyObject *py_name, int family, PyObject *py_addr,
+                         PyObject *py_netmask, PyObject *py_dstaddr) {
+    int ret = -1;
+    PyObject *py_tuple = NULL;
+
+    py_tuple = Py_BuildValue(
+        "(OiOOOO)",
+        py_name,
+        family,
+        py_addr,
+        py_netmask,
+        (flags & IFF_BROADCAST) ? py_dstaddr : Py_None,
+        (! (flags & IFF_BROADCAST) && (flags & IFF_POINTOPOINT)) ?
+            py_dstaddr : Py_None);
+    if (py_tuple == NULL)
+        goto out;
+    ret = PyList_Append(py_retlist, py_tuple);
+
+out:
+    Py_DECREF(py_name);
+    Py_XDECREF(py_addr);
+    Py_XDECREF(py_netmask);
+    Py_XDECREF(py_dstaddr);
+    Py_XDECREF(py_tuple);
+    return ret;
+}
+
+
+/*
+ * Callback for the RTM_GETLINK dump of psutil_net_if_addrs(): remember
+ * index, name and flags of the link and append its MAC address.
+ */
+static int
+psutil_net_if_addrs_link(struct nlmsghdr *nlh, void *arg) {
+    int ret;
+    psutil_net_if_addrs_ctx *ctx = (psutil_net_if_addrs_ctx *)arg;
+    struct rtattr *tb[IFLA_MAX + 1];
+    struct ifinfomsg *ifi;
+    psutil_rtnl_link *link;
+    PyObject *py_name = NULL;
+    PyObject *py_addr = NULL;
+    PyObject *py_broadcast;
+
+    if (nlh->nlmsg_type != RTM_NEWLINK)
+        return 0;
+    ifi = psutil_rtnl_parse_link(nlh, tb);
+    if (tb[IFLA_IFNAME] == NULL)
+        return 0;
+
+    if (ctx->nlinks == ctx->size) {
+        ctx->size = ctx->size ? ctx->size * 2 : 64;
+        link = realloc(ctx->links, ctx->size * sizeof(psutil_rtnl_link));
+        if (link == NULL) {
+            PyErr_NoMemory();
+            return -1;
+        }
+        ctx->links = link;
+    }
+    link = &ctx->links[ctx->nlinks++];
+    link->index = ifi->ifi_index;
+    link->flags = ifi->ifi_flags;
+    memset(link->name, 0, sizeof(link->name));
+    strncpy(link->name, (char *)RTA_DATA(tb[IFLA_IFNAME]),
+            sizeof(link->name) - 1);
+
+    if (! ctx->want_link || tb[IFLA_ADDRESS] == NULL ||
+            RTA_PAYLOAD(tb[IFLA_ADDRESS]) == 0)
+        return 0;
+    ret = psutil_rtnl_nic_wanted(ctx->py_nics, link->name, &py_name);
+    if (ret != 1)
+        return ret;
+    py_addr = psutil_rtnl_lladdr(tb[IFLA_ADDRESS]);
+    if (py_addr == NULL)
+        goto error;
+    py_broadcast = psutil_rtnl_lladdr(tb[IFLA_BROADCAST]);
+    if (py_broadcast == NULL)
+        goto error;
+    Py_INCREF(Py_None);
+    return psutil_rtnl_addrs_append(
+        ctx->py_retlist, link->flags, py_name, AF_PACKET, py_addr, Py_None,
+        py_broadcast);
+
+error:
+    Py_DECREF(py_name);
+    Py_XDECREF(py_addr);
+    return -1;
+}
+
+
+static int
+psutil_rtnl_link_cmp(const void *a, const void *b) {
+    return ((const psutil_rtnl_link *)a)->index -
+           ((const psutil_rtnl_link *)b)->index;
+}
+
+
+/*
+ * Callback for the RTM_GETADDR dump of psutil_net_if_addrs(): append
+ * an IPv4 / IPv6 address. Same as getifaddrs(), the NIC name is the
+ * address label (e.g. "eth0:1") if any, and on point-to-point links
+ * IFA_LOCAL is the address while IFA_ADDRESS is the peer.
+ */
+static int
+psutil_net_if_addrs_addr(struct nlmsghdr *nlh, void *arg) {
+    int ret;
+    int attrlen;
+    psutil_net_if_addrs_ctx *ctx = (psutil_net_if_addrs_ctx *)arg;
+    struct ifaddrmsg *ifa = (struct ifaddrmsg *)NLMSG_DATA(nlh);
+    struct rtattr *attr;
+    void *address = NULL;
+    void *local = NULL;
+    void *broadcast = NULL;
+    const char *label = NULL;
+    psutil_rtnl_link key;
+    psutil_rtnl_link *link;
+    PyObject *py_name = NULL;
+    PyObject *py_addr = NULL;
+    PyObject *py_netmask = NULL;
+    PyObject *py_dstaddr;
+
+    if (nlh->nlmsg_type != RTM_NEWADDR)
+        return 0;
+    if (! ((ifa->ifa_family == AF_INET && ctx->want_inet) ||
+           (ifa->ifa_family == AF_INET6 && ctx->want_inet6)))
+        return 0;
+    key.index = ifa->ifa_index;
+    link = bsearch(&key, ctx->links, ctx->nlinks, sizeof(psutil_rtnl_link),
+                   psutil_rtnl_link_cmp);
+    if (link == NULL)
+        return 0;
+
+    attrlen = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*ifa));
+    for (attr = IFA_RTA(ifa); RTA_OK(attr, attrlen);
+            attr = RTA_NEXT(attr, attrlen)) {
+        switch (attr->rta_type) {
+            case IFA_ADDRESS:
+                address = RTA_DATA(attr);
+                break;
+            case IFA_LOCAL:
+                local = RTA_DATA(attr);
+                break;
+            case IFA_BROADCAST:
+                broadcast = RTA_DATA(attr);
+                break;
+            case IFA_LABEL:
+                label = (const char *)RTA_DATA(attr);
+                break;
+        }
+    }
+    if (address == NULL && local == NULL)
+        return 0;
+    ret = psutil_rtnl_nic_wanted(ctx->py_nics, label ? label : link->name,
+                                 &py_name);
+    if (ret != 1)
+        return ret;
+    py_addr = psutil_rtnl_inaddr(ifa->ifa_family, local ? local : address,
+                                 link->name);
+    if (py_addr == NULL)
+        goto error;
+    py_netmask = psutil_rtnl_netmask(ifa->ifa_family, ifa->ifa_prefixlen);
+    if (py_netmask == NULL)
+        goto error;
+    py_dstaddr = psutil_rtnl_inaddr(
+        ifa->ifa_family, broadcast ? broadcast : (local ? address : NULL),
+        link->name);
+    if (py_dstaddr == NULL)
+        goto error;
+    return psutil_rtnl_addrs_append(
+        ctx->py_retlist, link->flags, py_name, ifa->ifa_family, py_addr,
+        py_netmask, py_dstaddr);
+
+error:
+    Py_DECREF(py_name);
+    Py_XDECREF(py_addr);
+    Py_XDECREF(py_netmask);
+    return -1;
+}
+
+
+/*
+ * Return NICs addresses as a list of
+ * (name, family, address, netmask, broadcast, ptp) tuples, same as
+ * psutil_net_if_addrs() in _psutil_posix.c, but using one RTM_GETLINK
+ * plus one RTM_GETADDR dump instead of getifaddrs().
+ * Optional "nics" and "families" containers filter the result before
+ * any Python object is built for addresses which are not wanted.
+ */
+PyObject *
+psutil_net_if_addrs(PyObject *self, PyObject *args) {
+    PyObject *py_families = Py_None;
+    psutil_net_if_addrs_ctx ctx;
+    struct {
+        struct nlmsghdr nlh;
+        struct ifinfomsg ifi;
+    } linkreq;
+    struct {
+        struct nlmsghdr nlh;
+        struct ifaddrmsg ifa;
+    } addrreq;
+
+    memset(&ctx, 0, sizeof(ctx));
+    ctx.py_nics = Py_None;
+    if (! PyArg_ParseTuple(args, "|OO", &ctx.py_nics, &py_families))
+        return NULL;
+    if ((ctx.want_link = psutil_rtnl_family_wanted(py_families,
+                                                   AF_PACKET)) == -1)
+        return NULL;
+    if ((ctx.want_inet = psutil_rtnl_family_wanted(py_families,
+                                                   AF_INET)) == -1)
+        return NULL;
+    if ((ctx.want_inet6 = psutil_rtnl_family_wanted(py_families,
+                                                    AF_INET6)) == -1)
+        return NULL;
+    ctx.py_retlist = PyList_New(0);
+    if (ctx.py_retlist == NULL)
+        return NULL;
+
+    // Links are always needed for names and flags.
+    memset(&linkreq, 0, sizeof(linkreq));
+    linkreq.nlh.nlmsg_type = RTM_GETLINK;
+    linkreq.ifi.ifi_family = AF_UNSPEC;
+    if (psutil_netlink_dump(NETLINK_ROUTE, -1, &linkreq,
+                            sizeof(linkreq), psutil_net_if_addrs_link,
+                            &ctx) != 0)
+        goto error;
+    if (ctx.nlinks > 0) {
+        qsort(ctx.links, ctx.nlinks, sizeof(psutil_rtnl_link),
+              psutil_rtnl_link_cmp);
+    }
+
+    if (ctx.want_inet || ctx.want_inet6) {
+        memset(&addrreq, 0, sizeof(addrreq));
+        addrreq.nlh.nlmsg_type = RTM_GETADDR;
+        if (! ctx.want_inet6)
+            addrreq.ifa.ifa_family = AF_INET;
+        else if (! ctx.want_inet)
+            addrreq.ifa.ifa_family = AF_INET6;
+        else
+            addrreq.ifa.ifa_family = AF_UNSPEC;
+        if (psutil_netlink_dump(NETLINK_ROUTE, -1, &addrreq,
+                                sizeof(addrreq), psutil_net_if_addrs_addr,
+                                &ctx) != 0)
+            goto error;
+    }
+
+    free(ctx.links);
+    return ctx.py_retlist;
+
+error:
+    free(ctx.links);
+    Py_DECREF(ctx.py_retlist);
+    return NULL;
+}
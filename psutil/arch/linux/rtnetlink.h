@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <Python.h>
+
+int psutil_ethtool_duplex_speed(int sock, const char *nic_name, int *duplex,
+                                int *speed);
+
+PyObject* psutil_net_io_counters(PyObject* self, PyObject* args);
+PyObject* psutil_net_if_stats(PyObject* self, PyObject* args);
+PyObject* psutil_net_if_addrs(PyObject* self, PyObject* args);
@@ -0,0 +1,354 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Socket listing via the NETLINK_SOCK_DIAG netlink interface (the one
+ * used by "ss"), which is a lot faster than parsing the /proc/net files
+ * as the kernel hands out sockets in binary form.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <string.h>
+#include <stdlib.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include <linux/tcp.h>
+#include <linux/unix_diag.h>
+
+#include "../../_psutil_common.h"
+#include "netlink.h"
+#include "sock_diag.h"
+
+#if PY_MAJOR_VERSION >= 3
+    #define PSUTIL_INET_DIAG_ARGS "ii|Iy#ii"
+#else
+    #define PSUTIL_INET_DIAG_ARGS "ii|Is#ii"
+#endif
+
+
+// Argument of psutil_inet_diag_append().
+typedef struct {
+    PyObject *py_retlist;
+    int details;
+} psutil_inet_diag_ctx;
+
+
+/*
+ * Turn a binary IPv4 / IPv6 address into a Python string.
+ */
+static PyObject *
+psutil_inet_ntop(int family, const void *src) {
+    char buf[INET6_ADDRSTRLEN];
+
+    if (inet_ntop(family, src, buf, sizeof(buf)) == NULL)
+        return PyErr_SetFromErrno(PyExc_OSError);
+    return Py_BuildValue("s", buf);
+}
+
+
+/*
+ * Callback for psutil_net_inet_diag(): append a
+ * (inode, state, laddr, lport, raddr, rport) tuple to the list, plus
+ * (rqueue, wqueue, rtt, cwnd, total_retrans, unacked) if details were
+ * requested. The last 4 come from struct tcp_info and are -1 if not
+ * available (UDP sockets).
+ */
+static int
+psutil_inet_diag_append(struct nlmsghdr *nlh, void *arg) {
+    int attrlen;
+    struct inet_diag_msg *diag;
+    struct rtattr *attr;
+    struct tcp_info info;
+    long long rtt = -1;
+    long long cwnd = -1;
+    long long retrans = -1;
+    long long unacked = -1;
+    psutil_inet_diag_ctx *ctx = (psutil_inet_diag_ctx *)arg;
+    PyObject *py_laddr = NULL;
+    PyObject *py_raddr = NULL;
+    PyObject *py_tuple = NULL;
+
+    if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY ||
+            nlh->nlmsg_len < NLMSG_LENGTH(sizeof(*diag)))
+        return 0;
+    diag = (struct inet_diag_msg *)NLMSG_DATA(nlh);
+
+    py_laddr = psutil_inet_ntop(diag->idiag_family, diag->id.idiag_src);
+    if (py_laddr == NULL)
+        goto error;
+    py_raddr = psutil_inet_ntop(diag->idiag_family, diag->id.idiag_dst);
+    if (py_raddr == NULL)
+        goto error;
+
+    if (! ctx->details) {
+        py_tuple = Py_BuildValue(
+            "(kiOiOi)",
+            (unsigned long)diag->idiag_inode,
+            (int)diag->idiag_state,
+            py_laddr,
+            (int)ntohs(diag->id.idiag_sport),
+            py_raddr,
+            (int)ntohs(diag->id.idiag_dport));
+    }
+    else {
+        attr = (struct rtattr *)(diag + 1);
+        attrlen = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*diag));
+        for (; RTA_OK(attr, attrlen); attr = RTA_NEXT(attr, attrlen)) {
+            if (attr->rta_type != INET_DIAG_INFO)
+                continue;
+            // older kernels may send a shorter struct
+            memset(&info, 0, sizeof(info));
+            memcpy(&info, RTA_DATA(attr),
+                   RTA_PAYLOAD(attr) < sizeof(info) ?
+                   RTA_PAYLOAD(attr) : sizeof(info));
+            rtt = info.tcpi_rtt;
+            cwnd = info.tcpi_snd_cwnd;
+            retrans = info.tcpi_total_retrans;
+            unacked = info.tcpi_unacked;
+        }
+        py_tuple = Py_BuildValue(
+            "(kiOiOikkLLLL)",
+            (unsigned long)diag->idiag_inode,
+            (int)diag->idiag_state,
+            py_laddr,
+            (int)ntohs(diag->id.idiag_sport),
+            py_raddr,
+            (int)ntohs(diag->id.idiag_dport),
+            (unsigned long)diag->idiag_rqueue,
+            (unsigned long)diag->idiag_wqueue,
+            rtt,
+            cwnd,
+            retrans,
+            unacked);
+    }
+    if (py_tuple == NULL)
+        goto error;
+    if (PyList_Append(ctx->py_retlist, py_tuple))
+        goto error;
+    Py_DECREF(py_laddr);
+    Py_DECREF(py_raddr);
+    Py_DECREF(py_tuple);
+    return 0;
+
+error:
+    Py_XDECREF(py_laddr);
+    Py_XDECREF(py_raddr);
+    Py_XDECREF(py_tuple);
+    return -1;
+}
+
+
+/*
+ * Dump all the TCP or UDP sockets of the given address family via
+ * NETLINK_SOCK_DIAG and return a list of
+ * (inode, state, laddr, lport, raddr, rport) tuples, where state is
+ * the TCP_* state number as defined by the kernel.
+ * Optionally only dump sockets whose state bit is set in the "states"
+ * mask and which pass an inet_diag bytecode filter (a sequence of
+ * struct inet_diag_bc_op), so that the others never leave the kernel.
+ * If "details" is true also ask for struct tcp_info and return queue
+ * lengths and TCP internals, see psutil_inet_diag_append().
+ * "netns_fd" is the network namespace to query, see
+ * psutil_netlink_dump().
+ */
+PyObject *
+psutil_net_inet_diag(PyObject *self, PyObject *args) {
+    int family;
+    int protocol;
+    unsigned int states = ~0U;  // all of them
+    const char *bytecode = NULL;
+    Py_ssize_t bclen = 0;
+    int details = 0;
+    int netns_fd = -1;
+    size_t reqlen;
+    char *buf = NULL;
+    struct nlmsghdr *nlh;
+    struct inet_diag_req_v2 *req;
+    struct rtattr *rta;
+    psutil_inet_diag_ctx ctx;
+    PyObject *py_retlist = NULL;
+
+    if (! PyArg_ParseTuple(args, PSUTIL_INET_DIAG_ARGS, &family, &protocol,
+                           &states, &bytecode, &bclen, &details,
+                           &netns_fd))
+        return NULL;
+    if (bclen % 4 != 0) {
+        PyErr_SetString(PyExc_ValueError,
+                        "bytecode length must be a multiple of 4");
+        return NULL;
+    }
+
+    reqlen = NLMSG_LENGTH(sizeof(*req));
+    if (bclen > 0)
+        reqlen = NLMSG_ALIGN(reqlen) + RTA_SPACE(bclen);
+    buf = calloc(1, reqlen);
+    if (buf == NULL) {
+        PyErr_NoMemory();
+        return NULL;
+    }
+    nlh = (struct nlmsghdr *)buf;
+    nlh->nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    req = (struct inet_diag_req_v2 *)NLMSG_DATA(nlh);
+    req->sdiag_family = family;
+    req->sdiag_protocol = protocol;
+    req->idiag_states = states;
+    if (details)
+        req->idiag_ext |= 1 << (INET_DIAG_INFO - 1);
+    if (bclen > 0) {
+        rta = (struct rtattr *)(buf + NLMSG_ALIGN(
+            NLMSG_LENGTH(sizeof(*req))));
+        rta->rta_type = INET_DIAG_REQ_BYTECODE;
+        rta->rta_len = RTA_LENGTH(bclen);
+        memcpy(RTA_DATA(rta), bytecode, bclen);
+    }
+
+    py_retlist = PyList_New(0);
+    if (py_retlist == NULL)
+        goto error;
+    ctx.py_retlist = py_retlist;
+    ctx.details = details;
+    if (psutil_netlink_dump(NETLINK_SOCK_DIAG, netns_fd, buf, reqlen,
+                            psutil_inet_diag_append, &ctx) != 0)
+        goto error;
+    free(buf);
+    return py_retlist;
+
+error:
+    free(buf);
+    Py_XDECREF(py_retlist);
+    return NULL;
+}
+
+
+/*
+ * Callback for psutil_net_unix_diag(): append a
+ * (inode, type, state, path, peer_inode, rqueue, wqueue) tuple to the
+ * list.
+ */
+static int
+psutil_unix_diag_append(struct nlmsghdr *nlh, void *arg) {
+    int attrlen;
+    int i;
+    char path[sizeof(((struct sockaddr_un *)0)->sun_path) + 1];
+    size_t pathlen = 0;
+    unsigned long peer = 0;
+    long long rqueue = -1;
+    long long wqueue = -1;
+    struct unix_diag_msg *diag;
+    struct unix_diag_rqlen *rqlen;
+    struct rtattr *attr;
+    PyObject *py_retlist = (PyObject *)arg;
+    PyObject *py_path = NULL;
+    PyObject *py_tuple = NULL;
+
+    if (nlh->nlmsg_type != SOCK_DIAG_BY_FAMILY ||
+            nlh->nlmsg_len < NLMSG_LENGTH(sizeof(*diag)))
+        return 0;
+    diag = (struct unix_diag_msg *)NLMSG_DATA(nlh);
+
+    attr = (struct rtattr *)(diag + 1);
+    attrlen = nlh->nlmsg_len - NLMSG_LENGTH(sizeof(*diag));
+    for (; RTA_OK(attr, attrlen); attr = RTA_NEXT(attr, attrlen)) {
+        switch (attr->rta_type) {
+            case UNIX_DIAG_NAME:
+                pathlen = RTA_PAYLOAD(attr);
+                if (pathlen > sizeof(path) - 1)
+                    pathlen = sizeof(path) - 1;
+                memcpy(path, RTA_DATA(attr), pathlen);
+                // filesystem paths include the terminating NUL
+                if (pathlen > 0 && path[0] != '\0' &&
+                        path[pathlen - 1] == '\0')
+                    pathlen--;
+                // abstract namespace; shown as "@name" in
+                // /proc/net/unix, with NULs replaced by "@"
+                for (i = 0; i < (int)pathlen; i++) {
+                    if (path[i] == '\0')
+                        path[i] = '@';
+                }
+                break;
+            case UNIX_DIAG_PEER:
+                if (RTA_PAYLOAD(attr) >= sizeof(__u32))
+                    peer = *(__u32 *)RTA_DATA(attr);
+                break;
+            case UNIX_DIAG_RQLEN:
+                if (RTA_PAYLOAD(attr) >= sizeof(*rqlen)) {
+                    rqlen = (struct unix_diag_rqlen *)RTA_DATA(attr);
+                    rqueue = rqlen->udiag_rqueue;
+                    wqueue = rqlen->udiag_wqueue;
+                }
+                break;
+        }
+    }
+    path[pathlen] = '\0';
+
+    py_path = PyUnicode_DecodeFSDefaultAndSize(path, (Py_ssize_t)pathlen);
+    if (py_path == NULL)
+        goto error;
+    py_tuple = Py_BuildValue(
+        "(kiiOkLL)",
+        (unsigned long)diag->udiag_ino,
+        (int)diag->udiag_type,
+        (int)diag->udiag_state,
+        py_path,
+        peer,
+        rqueue,
+        wqueue);
+    if (py_tuple == NULL)
+        goto error;
+    if (PyList_Append(py_retlist, py_tuple))
+        goto error;
+    Py_DECREF(py_path);
+    Py_DECREF(py_tuple);
+    return 0;
+
+error:
+    Py_XDECREF(py_path);
+    Py_XDECREF(py_tuple);
+    return -1;
+}
+
+
+/*
+ * Dump all the UNIX sockets via NETLINK_SOCK_DIAG and return a list
+ * of (inode, type, state, path, peer_inode, rqueue, wqueue) tuples,
+ * where state is a TCP_* state number. peer_inode is 0 if the socket
+ * is not connected, queue lengths are -1 if not available. Unlike
+ * /proc/net/unix this tells the socket each one is connected to.
+ * "netns_fd" is the network namespace to query, see
+ * psutil_netlink_dump().
+ */
+PyObject *
+psutil_net_unix_diag(PyObject *self, PyObject *args) {
+    int netns_fd = -1;
+    struct {
+        struct nlmsghdr nlh;
+        struct unix_diag_req req;
+    } req;
+    PyObject *py_retlist;
+
+    if (! PyArg_ParseTuple(args, "|i", &netns_fd))
+        return NULL;
+    py_retlist = PyList_New(0);
+    if (py_retlist == NULL)
+        return NULL;
+    memset(&req, 0, sizeof(req));
+    req.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    req.req.sdiag_family = AF_UNIX;
+    req.req.udiag_states = ~0U;  // all of them
+    req.req.udiag_show = UDIAG_SHOW_NAME | UDIAG_SHOW_PEER |
+                         UDIAG_SHOW_RQLEN;
+    if (psutil_netlink_dump(NETLINK_SOCK_DIAG, netns_fd, &req, sizeof(req),
+                            psutil_unix_diag_append, py_retlist) != 0) {
+        Py_DECREF(py_retlist);
+        return NULL;
+    }
+    return py_retlist;
+}
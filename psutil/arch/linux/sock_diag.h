@@ -0,0 +1,10 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ */
+
+#include <Python.h>
+
+PyObject* psutil_net_inet_diag(PyObject* self, PyObject* args);
+PyObject* psutil_net_unix_diag(PyObject* self, PyObject* args);
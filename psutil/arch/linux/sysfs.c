@@ -0,0 +1,168 @@
+/*
+ * Copyright (c) 2009, Giampaolo Rodola'. All rights reserved.
+ * Use of this source code is governed by a BSD-style license that can be
+ * found in the LICENSE file.
+ *
+ * Batch reader of small sysfs attribute files (cpufreq, hwmon, ...),
+ * which are opened once and then re-read via pread(2) for every sample,
+ * all at once.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sysfs.h"
+
+// Big enough for any attribute we read (a number, a governor, ...).
+#define PSUTIL_SYSFS_BUFSIZE 64
+
+
+/*
+ * Open the given files and return a list of fds, in the same order.
+ * An fd is -1 if the file does not exist or we're not allowed to read
+ * it (e.g. cpuinfo_cur_freq, which is only readable by root).
+ */
+PyObject *
+psutil_sysfs_open(PyObject *self, PyObject *args) {
+    const char *path;
+    int fd;
+    Py_ssize_t i;
+    Py_ssize_t n;
+    PyObject *py_paths;
+    PyObject *py_fd;
+    PyObject *py_retlist;
+
+    if (! PyArg_ParseTuple(args, "O!", &PyTuple_Type, &py_paths))
+        return NULL;
+    n = PyTuple_GET_SIZE(py_paths);
+    py_retlist = PyList_New(0);
+    if (py_retlist == NULL)
+        return NULL;
+
+    for (i = 0; i < n; i++) {
+#if PY_MAJOR_VERSION >= 3
+        path = PyUnicode_AsUTF8(PyTuple_GET_ITEM(py_paths, i));
+#else
+        path = PyString_AsString(PyTuple_GET_ITEM(py_paths, i));
+#endif
+        if (path == NULL)
+            goto error;
+        fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd == -1 && errno != ENOENT && errno != EACCES &&
+                errno != EPERM) {
+            PyErr_SetFromErrnoWithFilename(PyExc_OSError, path);
+            goto error;
+        }
+        py_fd = Py_BuildValue("i", fd);
+        if (py_fd == NULL || PyList_Append(py_retlist, py_fd) != 0) {
+            Py_XDECREF(py_fd);
+            if (fd != -1)
+                close(fd);
+            goto error;
+        }
+        Py_DECREF(py_fd);
+    }
+    return py_retlist;
+
+error:
+    for (i = 0; i < PyList_GET_SIZE(py_retlist); i++) {
+        fd = (int)PyLong_AsLong(PyList_GET_ITEM(py_retlist, i));
+        if (fd != -1)
+            close(fd);
+    }
+    Py_DECREF(py_retlist);
+    return NULL;
+}
+
+
+/*
+ * Read the files opened by psutil_sysfs_open() from offset 0 via
+ * pread(2) and return a list with their content: an int if it's a
+ * number (e.g. scaling_cur_freq or a negative temperature), else a str
+ * (e.g. scaling_governor), or None if the fd is -1 or it can't be read
+ * (e.g. EIO from a broken hwmon driver, or the CPU went offline).
+ * All files are read with the GIL released before building any Python
+ * object.
+ */
+PyObject *
+psutil_sysfs_read(PyObject *self, PyObject *args) {
+    char *buf;
+    char *bufs = NULL;
+    int *fds = NULL;
+    int neg;
+    ssize_t *lens = NULL;
+    ssize_t len;
+    Py_ssize_t i;
+    Py_ssize_t n;
+    PyObject *py_fds;
+    PyObject *py_value;
+    PyObject *py_retlist = NULL;
+
+    if (! PyArg_ParseTuple(args, "O!", &PyList_Type, &py_fds))
+        return NULL;
+    n = PyList_GET_SIZE(py_fds);
+    fds = malloc((n + 1) * sizeof(int));
+    lens = malloc((n + 1) * sizeof(ssize_t));
+    bufs = malloc((n + 1) * PSUTIL_SYSFS_BUFSIZE);
+    if (fds == NULL || lens == NULL || bufs == NULL) {
+        PyErr_NoMemory();
+        goto exit;
+    }
+    for (i = 0; i < n; i++) {
+        fds[i] = (int)PyLong_AsLong(PyList_GET_ITEM(py_fds, i));
+        if (fds[i] == -1 && PyErr_Occurred())
+            goto exit;
+    }
+
+    Py_BEGIN_ALLOW_THREADS
+    for (i = 0; i < n; i++) {
+        lens[i] = -1;
+        if (fds[i] == -1)
+            continue;
+        do {
+            lens[i] = pread(fds[i], bufs + i * PSUTIL_SYSFS_BUFSIZE,
+                            PSUTIL_SYSFS_BUFSIZE, 0);
+        } while (lens[i] == -1 && errno == EINTR);
+    }
+    Py_END_ALLOW_THREADS
+
+    py_retlist = PyList_New(n);
+    if (py_retlist == NULL)
+        goto exit;
+    for (i = 0; i < n; i++) {
+        buf = bufs + i * PSUTIL_SYSFS_BUFSIZE;
+        len = lens[i];
+        while (len > 0 && (buf[len - 1] == '\n' || buf[len - 1] == ' '))
+            len--;
+        if (len <= 0 || lens[i] == PSUTIL_SYSFS_BUFSIZE) {
+            // error, empty or (unexpectedly) too long
+            Py_INCREF(Py_None);
+            py_value = Py_None;
+        }
+        else {
+            buf[len] = '\0';
+            neg = buf[0] == '-';
+            if (len > neg &&
+                    strspn(buf + neg, "0123456789") == (size_t)(len - neg))
+                py_value = PyLong_FromLongLong(strtoll(buf, NULL, 10));
+            else
+                py_value = Py_BuildValue("s#", buf, (Py_ssize_t)len);
+            if (py_value == NULL) {
+                Py_CLEAR(py_retlist);
+                goto exit;
+            }
+        }
+        PyList_SET_ITEM(py_retlist, i, py_value);
+    }
+
+exit:
+    free(fds);
+    free(lens);
+    free(bufs);
+    return py_retlist;
+}
@@ -224,6 +224,66 @@ class TestConnectedSocketPairs(Base, unittest.TestCase):
             server.close()
             client.close()
 
+    @unittest.skipIf(SUNOS, "unreliable on SUONS")
+    def test_filters(self):
+        port = get_free_port()
+        server, client = tcp_socketpair(AF_INET, addr=("127.0.0.1", port))
+        try:
+            self._test_filters(port)
+        finally:
+            server.close()
+            client.close()
+
+    def _test_filters(self, port):
+        with create_sockets():
+            def conns(**kwargs):
+                return thisproc.connections(kind='all', **kwargs)
+
+            def check(expected, **kwargs):
+                cons = conns(**kwargs)
+                self.assertEqual(sorted(cons), sorted(expected))
+                # must be consistent with net_connections()
+                try:
+                    syscons = psutil.net_connections(kind='all', **kwargs)
+                except psutil.AccessDenied:
+                    return
+                syscons = [x[:-1] for x in syscons if x.pid == os.getpid()]
+                self.assertEqual(sorted(syscons), sorted(expected))
+
+            allcons = conns()
+            inet = [x for x in allcons if x.family in (AF_INET, AF_INET6)]
+            est = [x for x in allcons if x.status == psutil.CONN_ESTABLISHED]
+            self.assertEqual(len(est), 2)
+            check(est, status=psutil.CONN_ESTABLISHED)
+            check([x for x in allcons if x.status in (
+                  psutil.CONN_ESTABLISHED, psutil.CONN_LISTEN)],
+                  status=[psutil.CONN_ESTABLISHED, psutil.CONN_LISTEN])
+            check([x for x in allcons if x.status == psutil.CONN_NONE],
+                  status=psutil.CONN_NONE)
+            # ports
+            server_side = [x for x in est if x.laddr.port == port]
+            self.assertEqual(len(server_side), 1)
+            check(server_side, lport=port)
+            check(server_side, lport=(port, port), status=["ESTABLISHED"])
+            check([x for x in est if x.raddr.port == port], rport=port)
+            check(inet, lport=(0, 65535))
+            check([x for x in inet if x.raddr], rport=(1, 65535))
+            # addresses
+            check(est, laddr="127.0.0.1", raddr="127.0.0.1")
+            check(est, raddr="127.0.0.0/8")
+            check([], laddr="10.0.0.0/8")
+            check([x for x in inet if x.family == AF_INET],
+                  laddr="0.0.0.0/0")
+            if supports_ipv6():
+                check([x for x in inet if x.family == AF_INET6],
+                      laddr="::/0")
+            # invalid
+            self.assertRaises(ValueError, conns, status="foo")
+            self.assertRaises(ValueError, conns, lport=70000)
+            self.assertRaises(ValueError, conns, lport=(10, 1))
+            self.assertRaises(ValueError, conns, laddr="foo")
+            self.assertRaises(ValueError, conns, laddr="127.0.0.1/33")
+
     @unittest.skipIf(not POSIX, 'POSIX only')
     def test_unix(self):
         with unix_socket_path() as name:
@@ -502,6 +562,40 @@ class TestSystemWideConnections(Base, unittest.TestCase):
 
 class TestMisc(unittest.TestCase):
 
+    def test_details(self):
+        if not LINUX:
+            self.assertRaises(NotImplementedError, psutil.net_connections,
+                              details=True)
+            self.assertRaises(NotImplementedError, thisproc.connections,
+                              details=True)
+            return
+        with create_sockets():
+            cons = thisproc.connections(kind='all', details=True)
+            self.assertEqual(sorted([x[:6] for x in cons]),
+                             sorted(thisproc.connections(kind='all')))
+            for conn in cons:
+                check_connection_ntuple(psutil._common.pconn(*conn[:6]))
+                for name in ('send_queue', 'recv_queue', 'cwnd',
+                             'retransmits', 'unacked'):
+                    value = getattr(conn, name)
+                    if value is not None:
+                        self.assertIsInstance(value, int)
+                        self.assertGreaterEqual(value, 0)
+                if conn.rtt is not None:
+                    self.assertIsInstance(conn.rtt, float)
+
+    def test_netns_pid(self):
+        if not LINUX:
+            self.assertRaises(NotImplementedError, psutil.net_connections,
+                              netns_pid=os.getpid())
+            return
+        with create_sockets():
+            cons = psutil.net_connections(kind='all', netns_pid=os.getpid())
+            self.assertEqual(
+                sorted([x for x in cons if x.pid == os.getpid()]),
+                sorted([x for x in psutil.net_connections(kind='all')
+                        if x.pid == os.getpid()]))
+
     def test_connection_constants(self):
         ints = []
         strs = []
@@ -33,7 +33,10 @@ from psutil.tests import bind_unix_socket
 from psutil.tests import check_connection_ntuple
 from psutil.tests import get_kernel_version
 from psutil.tests import HAS_CONNECTIONS_UNIX
+from psutil.tests import HAS_CPU_TOPOLOGY
 from psutil.tests import HAS_NET_IO_COUNTERS
+from psutil.tests import HAS_NET_PROTO_COUNTERS
+from psutil.tests import HAS_NET_SOFTNET_STATS
 from psutil.tests import HAS_RLIMIT
 from psutil.tests import HAS_SENSORS_FANS
 from psutil.tests import HAS_SENSORS_TEMPERATURES
@@ -124,6 +127,15 @@ class TestAvailability(unittest.TestCase):
     def test_sensors_fans(self):
         self.assertEqual(hasattr(psutil, "sensors_fans"), LINUX)
 
+    def test_net_proto_counters(self):
+        self.assertEqual(hasattr(psutil, "net_proto_counters"), LINUX)
+
+    def test_net_softnet_stats(self):
+        self.assertEqual(hasattr(psutil, "net_softnet_stats"), LINUX)
+
+    def test_cpu_topology(self):
+        self.assertEqual(hasattr(psutil, "cpu_topology"), LINUX)
+
     def test_battery(self):
         self.assertEqual(hasattr(psutil, "sensors_battery"),
                          LINUX or WINDOWS or FREEBSD or MACOS)
@@ -170,6 +182,9 @@ class TestAvailability(unittest.TestCase):
         self.assertEqual(
             hasit, False if OPENBSD or NETBSD or AIX or MACOS else True)
 
+    def test_proc_memory_maps_iter(self):
+        self.assertEqual(hasattr(psutil.Process, "memory_maps_iter"), LINUX)
+
 
 # ===================================================================
 # --- Test deprecations
@@ -251,12 +266,37 @@ class TestSystem(unittest.TestCase):
         for ifname, _ in psutil.net_if_stats().items():
             self.assertIsInstance(ifname, str)
 
+    @unittest.skipIf(not HAS_CPU_TOPOLOGY, 'not supported')
+    def test_cpu_topology(self):
+        for cpu in psutil.cpu_topology():
+            self.assertIsInstance(cpu.cpu, int)
+            self.assertIsInstance(cpu.siblings, tuple)
+            for cache in cpu.caches:
+                self.assertIsInstance(cache.type, (str, type(None)))
+                self.assertIsInstance(cache.shared_cpus, tuple)
+
     @unittest.skipIf(not HAS_NET_IO_COUNTERS, 'not supported')
     def test_net_io_counters(self):
         # Duplicate of test_system.py. Keep it anyway.
         for ifname, _ in psutil.net_io_counters(pernic=True).items():
             self.assertIsInstance(ifname, str)
 
+    @unittest.skipIf(not HAS_NET_PROTO_COUNTERS, 'not supported')
+    def test_net_proto_counters(self):
+        # Duplicate of test_linux.py. Keep it anyway.
+        for group, counters in psutil.net_proto_counters().items():
+            self.assertIsInstance(group, str)
+            for name, value in counters.items():
+                self.assertIsInstance(name, str)
+                self.assertIsInstance(value, (int, long, dict))
+
+    @unittest.skipIf(not HAS_NET_SOFTNET_STATS, 'not supported')
+    def test_net_softnet_stats(self):
+        for stats in psutil.net_softnet_stats():
+            for value in stats:
+                self.assertIsInstance(value, (int, long))
+                self.assertGreaterEqual(value, 0)
+
     @unittest.skipIf(not HAS_SENSORS_FANS, "not supported")
     def test_sensors_fans(self):
         # Duplicate of test_system.py. Keep it anyway.
@@ -325,6 +365,8 @@ class TestFetchAllProcesses(unittest.TestCase):
                 args = (psutil.RLIMIT_NOFILE,)
             elif name == 'memory_maps':
                 kwargs = {'grouped': False}
+            elif name == 'memory_maps_iter':
+                return list(attr(grouped=False))
             return attr(*args, **kwargs)
         else:
             return attr
@@ -620,6 +662,9 @@ class TestFetchAllProcesses(unittest.TestCase):
                     self.assertIsInstance(value, (int, long))
                     self.assertGreaterEqual(value, 0)
 
+    def memory_maps_iter(self, ret, proc):
+        self.memory_maps(ret, proc)
+
     def num_handles(self, ret, proc):
         self.assertIsInstance(ret, int)
         self.assertGreaterEqual(ret, 0)
@@ -10,13 +10,17 @@ from __future__ import division
 import collections
 import contextlib
 import errno
+import fnmatch
 import glob
 import io
 import os
 import re
+import select
 import shutil
+import signal
 import socket
 import struct
+import subprocess
 import tempfile
 import textwrap
 import time
@@ -24,10 +28,17 @@ import warnings
 
 import psutil
 from psutil import LINUX
+from psutil._common import ENCODING
+from psutil._common import ENCODING_ERRS
 from psutil._compat import basestring
 from psutil._compat import PY3
 from psutil._compat import u
+from psutil.tests import bind_socket
 from psutil.tests import call_until
+from psutil.tests import create_sockets
+from psutil.tests import DEVNULL
+from psutil.tests import get_test_subprocess
+from psutil.tests import GLOBAL_TIMEOUT
 from psutil.tests import HAS_BATTERY
 from psutil.tests import HAS_CPU_FREQ
 from psutil.tests import HAS_RLIMIT
@@ -35,16 +46,21 @@ from psutil.tests import MEMORY_TOLERANCE
 from psutil.tests import mock
 from psutil.tests import PYPY
 from psutil.tests import pyrun
+from psutil.tests import PYTHON_EXE
 from psutil.tests import reap_children
 from psutil.tests import reload_module
 from psutil.tests import retry_on_failure
 from psutil.tests import safe_rmpath
 from psutil.tests import sh
 from psutil.tests import skip_on_not_implemented
+from psutil.tests import tcp_socketpair
 from psutil.tests import TESTFN
 from psutil.tests import ThreadTask
 from psutil.tests import TRAVIS
 from psutil.tests import unittest
+from psutil.tests import unix_socket_path
+from psutil.tests import unix_socketpair
+from psutil.tests import wait_for_file
 from psutil.tests import which
 
 
@@ -92,6 +108,27 @@ def get_mac_address(ifname):
         return ''.join(['%02x:' % ord(char) for char in info[18:24]])[:-1]
 
 
+@contextlib.contextmanager
+def non_utf8_nic():
+    """Create a veth pair one end of which has a non UTF-8 name (legal
+    on Linux) and yield that name, decoded as psutil does. Requires
+    root.
+    """
+    name = b"psutil\xff0"
+    try:
+        subprocess.check_call(
+            [b"ip", b"link", b"add", name, b"type", b"veth", b"peer",
+             b"name", b"psutil0"], stdout=DEVNULL, stderr=DEVNULL)
+    except (OSError, subprocess.CalledProcessError):
+        raise unittest.SkipTest("can't create a veth NIC")
+    try:
+        subprocess.call([b"ip", b"link", b"set", name, b"up"])
+        subprocess.call([b"ip", b"link", b"set", b"psutil0", b"up"])
+        yield name.decode(ENCODING, ENCODING_ERRS) if PY3 else name
+    finally:
+        subprocess.call([b"ip", b"link", b"del", name])
+
+
 def free_swap():
     """Parse 'free' cmd and return swap memory's s total, used and free
     values.
@@ -182,6 +219,32 @@ def mock_open_exception(for_path, exc):
         yield m
 
 
+def write_files(root, files):
+    """Create *files* ({relpath: content}) under the *root* directory,
+    e.g. to emulate a /sys tree.
+    """
+    for relpath, content in files.items():
+        path = os.path.join(root, relpath)
+        if not os.path.isdir(os.path.dirname(path)):
+            os.makedirs(os.path.dirname(path))
+        with open(path, "w") as f:
+            f.write(content)
+
+
+@contextlib.contextmanager
+def fake_sysfs(files):
+    """Create a temporary directory containing *files*
+    ({relpath: content}), e.g. to emulate a /sys tree, and yield its
+    path.
+    """
+    tdir = tempfile.mkdtemp()
+    try:
+        write_files(tdir, files)
+        yield tdir
+    finally:
+        shutil.rmtree(tdir)
+
+
 # =====================================================================
 # --- system virtual memory
 # =====================================================================
@@ -607,6 +670,101 @@ class TestSystemCPUTimes(unittest.TestCase):
         else:
             self.assertNotIn('guest_nice', fields)
 
+    def test_per_cpu_against_procfs(self):
+        with open("/proc/stat") as f:
+            lines = [x for x in f if re.match(r"cpu\d", x)]
+        times = psutil.cpu_times(percpu=True)
+        self.assertEqual(len(times), len(lines))
+        for line, nt in zip(lines, times):
+            values = line.split()[1:len(nt._fields) + 1]
+            for field, value in zip(nt._fields, values):
+                # may increase in the meantime
+                self.assertAlmostEqual(
+                    getattr(nt, field),
+                    float(value) / psutil._pslinux.CLOCK_TICKS, delta=1)
+
+    def test_stat_parse(self):
+        content = textwrap.dedent("""\
+            cpu  2 4 6 8 10 12 14 16 0 0
+            cpu0 1 2 3 4 5 6 7 8 0 0
+            cpu1 1 2 3 4 5 6 7 8 0 0
+            intr 12345 0 0
+            cpu2 1 2 3 4 5 6 7 8 0 0
+            """).encode()
+        cext = psutil._pslinux.cext
+        nfields, sample = cext.cpu_stat_parse(content, 100)
+        self.assertEqual(nfields, 10)
+        self.assertEqual(
+            cext.cpu_stat_times(sample),
+            [(0.01, 0.02, 0.03, 0.04, 0.05, 0.06, 0.07, 0.08, 0.0, 0.0)] * 2)
+        # old kernels: missing fields
+        nfields, sample = cext.cpu_stat_parse(
+            b"cpu  1 2 3 4 5 6 7\ncpu0 1 2 3 4 5 6 7\n", 1)
+        self.assertEqual(nfields, 7)
+        self.assertEqual(cext.cpu_stat_times(sample),
+                         [(1.0, 2.0, 3.0, 4.0, 5.0, 6.0, 7.0)])
+        self.assertRaises(ValueError, cext.cpu_stat_times, b"x")
+        self.assertRaises(ValueError, cext.cpu_stat_percent, b"x", b"x")
+        # bad headers: the sample is (ncpus, nfields, clock_ticks)
+        # followed by ncpus rows of 10 counters
+        row = struct.pack("10Q", *range(10))
+        for header in [(1, 11, 100.0), (1, 1000, 100.0), (1, 6, 100.0),
+                       (1, 10, 0.0), (1, 10, -1.0), (1, 10, float("nan")),
+                       (2, 10, 100.0), (0, 10, 100.0)]:
+            bad = struct.pack("IId", *header) + row
+            self.assertRaises(ValueError, cext.cpu_stat_times, bad)
+            self.assertRaises(ValueError, cext.cpu_stat_percent, bad, bad)
+            self.assertRaises(ValueError, cext.cpu_stat_percent, sample, bad)
+        good = struct.pack("IId", 1, 10, 100.0) + row
+        self.assertEqual(len(cext.cpu_stat_times(good)), 1)
+
+    def test_percpu_percent_against_python(self):
+        # The native math of cpu_percent(percpu=True) and
+        # cpu_times_percent(percpu=True) is supposed to match the
+        # Python implementation.
+        def stat(rows):
+            lines = ["cpu  %s" % " ".join(["0"] * 10)]
+            for i, row in enumerate(rows):
+                lines.append("cpu%s %s" % (i, " ".join(map(str, row))))
+            return "\n".join(lines) + "\nintr 0\n"
+
+        def percents(native, stat1, stat2):
+            def sleep(interval):
+                with open(os.path.join(tdir, "stat"), "w") as f:
+                    f.write(stat2)
+
+            with open(os.path.join(tdir, "stat"), "w") as f:
+                f.write(stat1)
+            with mock.patch("psutil._NATIVE_PER_CPU", native):
+                with mock.patch("psutil.time.sleep", side_effect=sleep):
+                    ret = psutil.cpu_percent(interval=1, percpu=True)
+                with open(os.path.join(tdir, "stat"), "w") as f:
+                    f.write(stat1)
+                with mock.patch("psutil.time.sleep", side_effect=sleep):
+                    return ret, psutil.cpu_times_percent(
+                        interval=1, percpu=True)
+
+        rows1 = [[3, 0, 7, 100, 2, 0, 1, 0, 0, 0],
+                 [500, 20, 300, 9000, 70, 5, 33, 8, 200, 10],
+                 [10, 10, 10, 10, 10, 10, 10, 10, 10, 10]]
+        rows2 = [[3, 0, 7, 100, 2, 0, 1, 0, 0, 0],  # idle CPU
+                 [577, 21, 345, 9123, 80, 5, 40, 9, 250, 10],
+                 [5, 10, 12, 3, 30, 10, 10, 10, 10, 10]]  # decreasing
+        tdir = tempfile.mkdtemp()
+        try:
+            psutil.PROCFS_PATH = tdir
+            native = percents(True, stat(rows1), stat(rows2))
+            python = percents(False, stat(rows1), stat(rows2))
+        finally:
+            psutil.PROCFS_PATH = "/proc"
+            shutil.rmtree(tdir)
+            # the Python implementation stores namedtuples
+            psutil._last_per_cpu_times = psutil._per_cpu_sample()
+            psutil._last_per_cpu_times_2 = psutil._per_cpu_sample()
+        self.assertEqual(native, python)
+        self.assertEqual(native[0][0], 0.0)
+        self.assertEqual(len(native[1]), 3)
+
 
 @unittest.skipIf(not LINUX, "LINUX only")
 class TestSystemCPUCountLogical(unittest.TestCase):
@@ -692,33 +850,181 @@ class TestSystemCPUCountPhysical(unittest.TestCase):
         assert m1.called
         assert m2.called
 
+    def test_emulate_multi_sockets(self):
+        # Core IDs are the same on both sockets, and there are more than
+        # 10 CPUs.
+        files = {}
+        for cpu in range(12):
+            topology = "/sys/devices/system/cpu/cpu%s/topology/" % cpu
+            files[topology + "core_id"] = cpu % 6
+            files[topology + "physical_package_id"] = cpu // 6
+
+        def open_mock(name, *args, **kwargs):
+            if name in files:
+                return io.BytesIO(("%d\n" % files[name]).encode())
+            raise IOError(errno.ENOENT, "")
+
+        paths = sorted([x for x in files if x.endswith("core_id")])
+        with mock.patch('glob.glob', return_value=paths):
+            with mock.patch('psutil._common.open', create=True,
+                            side_effect=open_mock):
+                self.assertEqual(psutil._pslinux.cpu_count_physical(), 12)
+
+
+@unittest.skipIf(not LINUX, "LINUX only")
+class TestSystemCPUTopology(unittest.TestCase):
+
+    @staticmethod
+    def cpu(num, package, core, siblings, node=None, **kwargs):
+        files = {
+            "topology/physical_package_id": package,
+            "topology/core_id": core,
+            "topology/thread_siblings_list": siblings,
+            "cache/index0/level": 1,
+            "cache/index0/type": "Data",
+            "cache/index0/id": core,
+            "cache/index0/size": "32K",
+            "cache/index0/shared_cpu_list": siblings,
+            "cache/index1/level": 3,
+            "cache/index1/type": "Unified",
+            "cache/index1/id": package,
+            "cache/index1/size": "16384K",
+            "cache/index1/shared_cpu_list": "%s-%s" % (
+                package * 4, package * 4 + 3),
+        }
+        if node is not None:
+            files["node%s/cpulist" % node] = ""
+        files.update(kwargs)
+        return dict([("cpu%s/%s" % (num, k), "%s\n" % v)
+                     for k, v in files.items() if v is not None])
+
+    def test_emulate_data(self):
+        # 2 packages, each with 2 cores with 2 threads.
+        files = {"cpufreq/policy0/scaling_cur_freq": "1000\n"}
+        for cpu in range(8):
+            package = cpu // 4
+            first = cpu // 2 * 2
+            files.update(self.cpu(
+                cpu, package, cpu // 2 % 2, "%s-%s" % (first, first + 1),
+                node=package))
+        with fake_sysfs(files) as path:
+            ret = psutil._pslinux.read_cpu_topology(path)
+        self.assertEqual([x.cpu for x in ret], list(range(8)))
+        cpu = ret[5]
+        self.assertEqual(cpu.package, 1)
+        self.assertIsNone(cpu.die)
+        self.assertEqual(cpu.core, 0)
+        self.assertEqual(cpu.siblings, (4, 5))
+        self.assertEqual(cpu.node, 1)
+        self.assertEqual(len(cpu.caches), 2)
+        self.assertEqual(cpu.caches[0], psutil._pslinux.scpucache(
+            1, "Data", 0, 32 * 1024, (4, 5)))
+        self.assertEqual(cpu.caches[1], psutil._pslinux.scpucache(
+            3, "Unified", 1, 16 * 1024 * 1024, (4, 5, 6, 7)))
+
+    def test_emulate_sorting(self):
+        # "cpu10" comes after "cpu2".
+        files = {}
+        for cpu in range(12):
+            files.update(self.cpu(cpu, 0, cpu, str(cpu)))
+        with fake_sysfs(files) as path:
+            ret = psutil._pslinux.read_cpu_topology(path)
+        self.assertEqual([x.cpu for x in ret], list(range(12)))
+        self.assertEqual([x.core for x in ret], list(range(12)))
+
+    def test_emulate_core_cpus_list(self):
+        # Linux >= 5.7 also provides die_id and core_cpus_list.
+        files = self.cpu(0, 0, 0, "0,2", **{
+            "topology/die_id": 1,
+            "topology/core_cpus_list": "0,2",
+            "topology/thread_siblings_list": None})
+        with fake_sysfs(files) as path:
+            cpu = psutil._pslinux.read_cpu_topology(path)[0]
+        self.assertEqual(cpu.die, 1)
+        self.assertEqual(cpu.siblings, (0, 2))
+
+    def test_emulate_offline(self):
+        # The topology of offline CPUs is not available.
+        files = {"cpu1/online": "0\n"}
+        files.update(self.cpu(0, 0, 0, "0"))
+        with fake_sysfs(files) as path:
+            ret = psutil._pslinux.read_cpu_topology(path)
+        self.assertEqual(ret[1], psutil._pslinux.scputopology(
+            1, None, None, None, (), None, ()))
+
+    def test_parse_cpu_list(self):
+        parse = psutil._pslinux.parse_cpu_list
+        self.assertEqual(parse("0"), (0, ))
+        self.assertEqual(parse("0-3,8,10-11"), (0, 1, 2, 3, 8, 10, 11))
+        self.assertEqual(parse(""), ())
+
+    def test_cached(self):
+        psutil.cpu_topology.cache_clear()
+        self.addCleanup(psutil.cpu_topology.cache_clear)
+        ret = psutil.cpu_topology()
+        with mock.patch("psutil._pslinux.read_cpu_topology") as m:
+            self.assertEqual(psutil.cpu_topology(), ret)
+            assert not m.called
+            psutil.cpu_topology.cache_clear()
+            psutil.cpu_topology()
+            assert m.called
+
+    def test_against_cpu_count(self):
+        # offline CPUs have no topology
+        ret = [x for x in psutil.cpu_topology() if x.core is not None]
+        self.assertEqual(len(ret), psutil.cpu_count())
+        self.assertEqual(
+            len(set([(x.package, x.die, x.core) for x in ret])),
+            psutil.cpu_count(logical=False))
+
 
 @unittest.skipIf(not LINUX, "LINUX only")
 class TestSystemCPUFrequency(unittest.TestCase):
 
-    @unittest.skipIf(not HAS_CPU_FREQ, "not supported")
+    @contextlib.contextmanager
+    def fake_cpufreq(self, files):
+        """Same as fake_sysfs() (a /sys/devices/system/cpu tree) but
+        also make cpu_freq() read it; yield the reader.
+        """
+        with fake_sysfs(files) as tdir:
+            reader = psutil._pslinux.CpuFreqReader(tdir)
+            try:
+                if not os.path.isdir(os.path.join(tdir, "cpufreq")):
+                    os.mkdir(os.path.join(tdir, "cpufreq"))
+                with mock.patch("psutil._pslinux.cpu_freq", reader.read,
+                                create=True):
+                    yield reader
+            finally:
+                if reader.dirs is not None:
+                    reader.close()
+
+    @staticmethod
+    def policy(path, curr, min_, max_, **kwargs):
+        files = {
+            "scaling_cur_freq": curr,
+            "scaling_min_freq": min_,
+            "scaling_max_freq": max_,
+        }
+        files.update(kwargs)
+        return dict([(os.path.join(path, k), "%s\n" % v)
+                     for k, v in files.items() if v is not None])
+
     def test_emulate_no_files(self):
-        with mock.patch("psutil._pslinux.glob.glob", return_value=[]):
+        with self.fake_cpufreq({}):
             self.assertIsNone(psutil.cpu_freq())
+            self.assertEqual(psutil.cpu_freq(percpu=True), [])
 
-    @unittest.skipIf(TRAVIS, "fails on Travis")
-    @unittest.skipIf(not HAS_CPU_FREQ, "not supported")
     def test_emulate_use_second_file(self):
         # https://github.com/giampaolo/psutil/issues/981
-        def glob_mock(pattern):
-            if pattern.startswith("/sys/devices/system/cpu/cpufreq/policy"):
-                flags.append(None)
-                return []
-            else:
-                flags.append(None)
-                return orig_glob(pattern)
-
-        flags = []
-        orig_glob = glob.glob
-        with mock.patch("psutil._pslinux.glob.glob", side_effect=glob_mock,
-                        create=True):
-            assert psutil.cpu_freq()
-            self.assertEqual(len(flags), 2)
+        files = {}
+        for cpu in (0, 2, 10):
+            files.update(self.policy("cpu%s/cpufreq" % cpu,
+                                     100000 * (cpu + 1), 0, 2000000))
+        with self.fake_cpufreq(files):
+            # '10' comes after '2'
+            self.assertEqual([x.current for x in
+                              psutil.cpu_freq(percpu=True)],
+                             [100.0, 300.0, 1100.0])
 
     @unittest.skipIf(not HAS_CPU_FREQ, "not supported")
     def test_emulate_use_cpuinfo(self):
@@ -749,92 +1055,142 @@ class TestSystemCPUFrequency(unittest.TestCase):
             reload_module(psutil._pslinux)
             reload_module(psutil)
 
-    @unittest.skipIf(not HAS_CPU_FREQ, "not supported")
     def test_emulate_data(self):
-        def open_mock(name, *args, **kwargs):
-            if name.endswith('/scaling_cur_freq'):
-                return io.BytesIO(b"500000")
-            elif name.endswith('/scaling_min_freq'):
-                return io.BytesIO(b"600000")
-            elif name.endswith('/scaling_max_freq'):
-                return io.BytesIO(b"700000")
-            else:
-                return orig_open(name, *args, **kwargs)
-
-        orig_open = open
-        patch_point = 'builtins.open' if PY3 else '__builtin__.open'
-        with mock.patch(patch_point, side_effect=open_mock):
-            with mock.patch(
-                    'glob.glob',
-                    return_value=['/sys/devices/system/cpu/cpufreq/policy0']):
-                freq = psutil.cpu_freq()
-                self.assertEqual(freq.current, 500.0)
-                self.assertEqual(freq.min, 600.0)
-                self.assertEqual(freq.max, 700.0)
+        files = self.policy("cpufreq/policy0", 500000, 600000, 700000)
+        with self.fake_cpufreq(files):
+            freq = psutil.cpu_freq()
+            self.assertEqual(freq.current, 500.0)
+            self.assertEqual(freq.min, 600.0)
+            self.assertEqual(freq.max, 700.0)
 
-    @unittest.skipIf(not HAS_CPU_FREQ, "not supported")
     def test_emulate_multi_cpu(self):
-        def open_mock(name, *args, **kwargs):
-            if name.endswith('/scaling_cur_freq'):
-                return io.BytesIO(b"100000")
-            elif name.endswith('/scaling_min_freq'):
-                return io.BytesIO(b"200000")
-            elif name.endswith('/scaling_max_freq'):
-                return io.BytesIO(b"300000")
-            else:
-                return orig_open(name, *args, **kwargs)
+        files = {}
+        for n in range(3):
+            files.update(self.policy("cpufreq/policy%s" % n,
+                                     100000, 200000, 300000))
+        with self.fake_cpufreq(files):
+            freq = psutil.cpu_freq()
+            self.assertEqual(freq.current, 100.0)
+            self.assertEqual(freq.min, 200.0)
+            self.assertEqual(freq.max, 300.0)
+            self.assertEqual(len(psutil.cpu_freq(percpu=True)), 3)
 
-        orig_open = open
-        patch_point = 'builtins.open' if PY3 else '__builtin__.open'
-        policies = ['/sys/devices/system/cpu/cpufreq/policy0',
-                    '/sys/devices/system/cpu/cpufreq/policy1',
-                    '/sys/devices/system/cpu/cpufreq/policy2']
-        with mock.patch(patch_point, side_effect=open_mock):
-            with mock.patch('glob.glob', return_value=policies):
-                freq = psutil.cpu_freq()
-                self.assertEqual(freq.current, 100.0)
-                self.assertEqual(freq.min, 200.0)
-                self.assertEqual(freq.max, 300.0)
-
-    @unittest.skipIf(TRAVIS, "fails on Travis")
-    @unittest.skipIf(not HAS_CPU_FREQ, "not supported")
     def test_emulate_no_scaling_cur_freq_file(self):
         # See: https://github.com/giampaolo/psutil/issues/1071
-        def open_mock(name, *args, **kwargs):
-            if name.endswith('/scaling_cur_freq'):
-                raise IOError(errno.ENOENT, "")
-            elif name.endswith('/cpuinfo_cur_freq'):
-                return io.BytesIO(b"200000")
-            else:
-                return orig_open(name, *args, **kwargs)
-
-        orig_open = open
-        patch_point = 'builtins.open' if PY3 else '__builtin__.open'
-        policies = ['/sys/devices/system/cpu/cpufreq/policy0',
-                    '/sys/devices/system/cpu/cpufreq/policy1',
-                    '/sys/devices/system/cpu/cpufreq/policy2']
-
-        with mock.patch(patch_point, side_effect=open_mock):
-            with mock.patch('glob.glob', return_value=policies):
-                freq = psutil.cpu_freq()
-                self.assertEqual(freq.current, 200)
+        files = {}
+        for n in range(3):
+            files.update(self.policy("cpufreq/policy%s" % n, None,
+                                     100000, 300000,
+                                     cpuinfo_cur_freq=200000))
+        with self.fake_cpufreq(files):
+            freq = psutil.cpu_freq()
+            self.assertEqual(freq.current, 200)
 
         # Also test that NotImplementedError is raised in case no
         # current freq file is present.
-
-        def open_mock(name, *args, **kwargs):
-            if name.endswith('/scaling_cur_freq'):
-                raise IOError(errno.ENOENT, "")
-            elif name.endswith('/cpuinfo_cur_freq'):
-                raise IOError(errno.ENOENT, "")
-            else:
-                return orig_open(name, *args, **kwargs)
-
-        orig_open = open
-        patch_point = 'builtins.open' if PY3 else '__builtin__.open'
-        with mock.patch(patch_point, side_effect=open_mock):
-            with mock.patch('glob.glob', return_value=policies):
-                self.assertRaises(NotImplementedError, psutil.cpu_freq)
+        files = self.policy("cpufreq/policy0", None, 100000, 300000)
+        with self.fake_cpufreq(files):
+            self.assertRaises(NotImplementedError, psutil.cpu_freq)
+
+    def test_emulate_cpuinfo_cur_freq_unused(self):
+        # cpuinfo_cur_freq may query the hardware: it's only read if
+        # there's no scaling_cur_freq.
+        files = self.policy("cpufreq/policy0", 100000, 100000, 300000,
+                            cpuinfo_cur_freq=200000)
+        files.update(self.policy("cpufreq/policy1", None, 100000, 300000,
+                                 cpuinfo_cur_freq=200000))
+        with self.fake_cpufreq(files) as reader:
+            self.assertEqual([x.current for x in
+                              psutil.cpu_freq(percpu=True)], [100, 200])
+            self.assertEqual(
+                [os.path.basename(x) for x in reader.paths
+                 if x.endswith("cur_freq")],
+                ["scaling_cur_freq", "cpuinfo_cur_freq"])
+
+    def test_emulate_details(self):
+        files = {}
+        for n, governor in enumerate(("powersave", "performance")):
+            files.update(self.policy(
+                "cpufreq/policy%s" % n, 1000000, 400000, 3000000,
+                scaling_governor=governor, cpuinfo_min_freq=400000,
+                cpuinfo_max_freq=4000000 * (n + 1)))
+        with self.fake_cpufreq(files):
+            ls = psutil.cpu_freq(percpu=True, details=True)
+            self.assertEqual(ls[0], psutil._pslinux.scpufreqdetails(
+                current=1000.0, min=400.0, max=3000.0, governor="powersave",
+                cpuinfo_min=400.0, cpuinfo_max=4000.0))
+            self.assertEqual(ls[1].governor, "performance")
+            freq = psutil.cpu_freq(details=True)
+            self.assertIsNone(freq.governor)
+            self.assertEqual(freq.cpuinfo_max, 6000.0)
+            self.assertEqual(psutil.cpu_freq()._fields,
+                             ('current', 'min', 'max'))
+
+    def test_emulate_details_cached(self):
+        # cpuinfo_min/max_freq are static and read once, the governor is
+        # read on every call.
+        files = self.policy("cpufreq/policy0", 1000000, 400000, 3000000,
+                            scaling_governor="powersave",
+                            cpuinfo_min_freq=400000,
+                            cpuinfo_max_freq=4000000)
+        with self.fake_cpufreq(files) as reader:
+            psutil.cpu_freq(details=True)
+            write_files(reader.path, self.policy(
+                "cpufreq/policy0", 1000000, 400000, 3000000,
+                scaling_governor="performance", cpuinfo_max_freq=5000000))
+            freq = psutil.cpu_freq(details=True)
+            self.assertEqual(freq.governor, "performance")
+            self.assertEqual(freq.cpuinfo_max, 4000.0)
+
+    def test_emulate_emfile(self):
+        # With no fds left the files are opened on every call.
+        files = self.policy("cpufreq/policy0", 500000, 600000, 700000)
+        with self.fake_cpufreq(files) as reader:
+            with mock.patch("psutil._pslinux.cext.sysfs_open",
+                            side_effect=OSError(errno.EMFILE, "")) as m:
+                self.assertEqual(psutil.cpu_freq().current, 500.0)
+                write_files(reader.path, self.policy(
+                    "cpufreq/policy0", 800000, 600000, 700000))
+                self.assertEqual(psutil.cpu_freq(), (800.0, 600.0, 700.0))
+                self.assertEqual(m.call_count, 1)
+            self.assertIsNone(reader.fds)
+
+    def test_emulate_files_kept_open(self):
+        files = self.policy("cpufreq/policy0", 500000, 600000, 700000)
+        with self.fake_cpufreq(files) as reader:
+            self.assertEqual(psutil.cpu_freq().current, 500.0)
+            with open(os.path.join(reader.path, "cpufreq", "policy0",
+                                   "scaling_cur_freq"), "w") as f:
+                f.write("800000\n")
+            with mock.patch("psutil._pslinux.glob.glob") as m:
+                with mock.patch("psutil._pslinux.cext.sysfs_open") as m2:
+                    self.assertEqual(psutil.cpu_freq().current, 800.0)
+            assert not m.called
+            assert not m2.called
+
+    def test_emulate_hotplug(self):
+        files = self.policy("cpufreq/policy0", 500000, 600000, 700000)
+        files["online"] = "0\n"
+        with self.fake_cpufreq(files) as reader:
+            self.assertEqual(len(psutil.cpu_freq(percpu=True)), 1)
+            write_files(reader.path, self.policy(
+                "cpufreq/policy1", 500000, 600000, 700000))
+            # not discovered until the online CPUs change
+            self.assertEqual(len(psutil.cpu_freq(percpu=True)), 1)
+            write_files(reader.path, {"online": "0-1\n"})
+            self.assertEqual(len(psutil.cpu_freq(percpu=True)), 2)
+
+    @unittest.skipIf(not glob.glob("/sys/devices/system/cpu/cpufreq/policy*"),
+                     "no cpufreq policies")
+    def test_against_sysfs(self):
+        ls = psutil.cpu_freq(percpu=True, details=True)
+        paths = psutil._pslinux._cpufreq_reader.discover()
+        self.assertEqual(len(ls), len(paths))
+        for freq, path in zip(ls, paths):
+            with open(os.path.join(path, "scaling_max_freq")) as f:
+                self.assertEqual(freq.max, int(f.read()) / 1000)
+            with open(os.path.join(path, "scaling_governor")) as f:
+                self.assertEqual(freq.governor, f.read().strip())
 
 
 @unittest.skipIf(not LINUX, "LINUX only")
@@ -870,6 +1226,57 @@ class TestSystemNetIfAddrs(unittest.TestCase):
                     self.assertEqual(addr.address, get_ipv4_address(name))
                 # TODO: test for AF_INET6 family
 
+    def test_rtnetlink_against_getifaddrs(self):
+        try:
+            rtnl = psutil._psplatform.cext.net_if_addrs()
+        except OSError:
+            raise unittest.SkipTest("NETLINK_ROUTE not supported")
+        self.assertEqual(rtnl, psutil._psplatform.cext_posix.net_if_addrs())
+
+    def test_rtnetlink_filters(self):
+        cext = psutil._psplatform.cext
+        try:
+            allnics = cext.net_if_addrs()
+        except OSError:
+            raise unittest.SkipTest("NETLINK_ROUTE not supported")
+        self.assertEqual(cext.net_if_addrs(None, None), allnics)
+        self.assertEqual(cext.net_if_addrs(frozenset(['lo', '?!?'])),
+                         [x for x in allnics if x[0] == 'lo'])
+        for fams in ([socket.AF_INET], [socket.AF_INET6], [psutil.AF_LINK],
+                     [socket.AF_INET, psutil.AF_LINK]):
+            self.assertEqual(cext.net_if_addrs(None, fams),
+                             [x for x in allnics if x[1] in fams])
+        self.assertEqual(cext.net_if_addrs(None, ()), [])
+        self.assertEqual(cext.net_if_addrs(('lo', ), (socket.AF_INET, )),
+                         [x for x in allnics
+                          if x[0] == 'lo' and x[1] == socket.AF_INET])
+        self.assertRaises(TypeError, cext.net_if_addrs, 1)
+        self.assertRaises(TypeError, cext.net_if_addrs, None, 1)
+
+    def test_non_utf8_name(self):
+        with non_utf8_nic() as name:
+            addrs = psutil.net_if_addrs(nics=[name])[name]
+            self.assertIn(psutil.AF_LINK, [x.family for x in addrs])
+            if os.path.exists("/proc/net/if_inet6"):
+                # IPv6 link-local addresses are suffixed with the NIC
+                # name; they're assigned once the link is up.
+                addrs = call_until(
+                    lambda: [x for x in psutil.net_if_addrs()[name]
+                             if x.family == socket.AF_INET6],
+                    "ret")
+                self.assertEqual(addrs[0].address.split("%")[1], name)
+
+    def test_getifaddrs_fallback(self):
+        with mock.patch("psutil._pslinux.cext.net_if_addrs",
+                        side_effect=OSError) as m:
+            fallback = psutil.net_if_addrs(families=[socket.AF_INET])
+            assert m.called
+        self.assertEqual(fallback,
+                         psutil.net_if_addrs(families=[socket.AF_INET]))
+        for addrs in fallback.values():
+            for addr in addrs:
+                self.assertEqual(addr.family, socket.AF_INET)
+
     # XXX - not reliable when having virtual NICs installed by Docker.
     # @unittest.skipIf(not which('ip'), "'ip' utility not available")
     # @unittest.skipIf(TRAVIS, "skipped on Travis")
@@ -902,6 +1309,37 @@ class TestSystemNetIfStats(unittest.TestCase):
                 self.assertEqual(stats.mtu,
                                  int(re.findall(r'(?i)MTU[: ](\d+)', out)[0]))
 
+    def test_rtnetlink_against_ioctl(self):
+        try:
+            psutil._psplatform.cext.net_if_stats()
+        except OSError:
+            raise unittest.SkipTest("NETLINK_ROUTE not supported")
+        with mock.patch("psutil._pslinux.cext.net_if_stats",
+                        side_effect=OSError) as m:
+            ioctl = psutil.net_if_stats()
+            assert m.called
+        self.assertEqual(psutil.net_if_stats(), ioctl)
+
+    def test_rtnetlink_nics(self):
+        cext = psutil._psplatform.cext
+        try:
+            allnics = cext.net_if_stats()
+        except OSError:
+            raise unittest.SkipTest("NETLINK_ROUTE not supported")
+        self.assertIn('lo', allnics)
+        self.assertEqual(cext.net_if_stats(None), allnics)
+        self.assertEqual(cext.net_if_stats(frozenset(['lo', '?!?'])),
+                         {'lo': allnics['lo']})
+        self.assertEqual(cext.net_if_stats(()), {})
+        # loopback has no speed
+        self.assertEqual(allnics['lo'][1:3], (cext.DUPLEX_UNKNOWN, 0))
+        self.assertRaises(TypeError, cext.net_if_stats, 1)
+
+    def test_non_utf8_name(self):
+        with non_utf8_nic() as name:
+            self.assertIn(name, psutil.net_if_stats())
+            self.assertEqual(list(psutil.net_if_stats(nics=[name])), [name])
+
 
 @unittest.skipIf(not LINUX, "LINUX only")
 class TestSystemNetIOCounters(unittest.TestCase):
@@ -948,13 +1386,431 @@ class TestSystemNetIOCounters(unittest.TestCase):
             self.assertAlmostEqual(
                 stats.dropout, ifconfig_ret['dropout'], delta=10)
 
+    def test_rtnetlink_against_procfs(self):
+        try:
+            psutil._psplatform.cext.net_io_counters()
+        except OSError:
+            raise unittest.SkipTest("NETLINK_ROUTE not supported")
+        with mock.patch("psutil._pslinux.cext.net_io_counters",
+                        side_effect=OSError) as m:
+            procfs = psutil.net_io_counters(pernic=True, nowrap=False)
+            assert m.called
+        nio = psutil.net_io_counters(pernic=True, nowrap=False)
+        self.assertEqual(sorted(nio.keys()), sorted(procfs.keys()))
+        for name, stats in nio.items():
+            self.assertEqual(stats._fields, procfs[name]._fields)
+            for field in stats._fields:
+                value = getattr(stats, field)
+                self.assertIsInstance(value, int)
+                # may increase in the meantime
+                self.assertGreaterEqual(value, getattr(procfs[name], field))
+                self.assertAlmostEqual(
+                    value, getattr(procfs[name], field), delta=1024 * 1024)
+
+    def test_non_utf8_name(self):
+        with non_utf8_nic() as name:
+            self.assertIn(name, psutil.net_io_counters(pernic=True))
+            with mock.patch("psutil._pslinux.cext.net_io_counters",
+                            side_effect=OSError) as m:
+                self.assertIn(name, psutil.net_io_counters(pernic=True))
+                assert m.called
+
+    def test_procfs_extra_fields(self):
+        content = textwrap.dedent("""\
+            Inter-|   Receive        |  Transmit
+             face |bytes    packets  |bytes    packets
+                lo: 1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16
+            """)
+        with mock_open_content('/proc/net/dev', content) as m:
+            with mock.patch("psutil._pslinux.cext.net_io_counters",
+                            side_effect=OSError):
+                nio = psutil.net_io_counters(pernic=True, nowrap=False)
+            assert m.called
+        self.assertEqual(
+            nio['lo'], psutil._pslinux.snetio(
+                bytes_sent=9, bytes_recv=1, packets_sent=10, packets_recv=2,
+                errin=3, errout=11, dropin=4, dropout=12, multicast=8,
+                fifoin=5, fifoout=13, framein=6, carrierout=15,
+                collisions=14, compressedin=7, compressedout=16))
+
+    @unittest.skipIf(
+        not getattr(psutil._psplatform, "NET_IO_COUNTERS_64BIT", False),
+        "32-bit counters")
+    def test_nowrap_64bit(self):
+        psutil.net_io_counters.cache_clear()
+        psutil.net_io_counters(nowrap=True)
+        for cache in psutil._common.wrap_numbers.cache_info():
+            self.assertNotIn('psutil.net_io_counters', cache)
+
+
+@unittest.skipIf(not LINUX, "LINUX only")
+class TestSystemNetProtoCounters(unittest.TestCase):
+
+    def setUp(self):
+        psutil.net_proto_counters.cache_clear()
+
+    tearDown = setUp
+
+    def write_procfs(self, tdir, files):
+        os.mkdir(os.path.join(tdir, "net"))
+        for name, content in files.items():
+            with open(os.path.join(tdir, "net", name), "w") as f:
+                f.write(textwrap.dedent(content))
+
+    def test_against_procfs(self):
+        with open("/proc/net/snmp") as f:
+            lines = f.read().splitlines()
+        ret = psutil.net_proto_counters(nowrap=False)
+        for i in range(0, len(lines), 2):
+            names = lines[i].split()
+            self.assertEqual(sorted(ret[names[0][:-1]].keys()),
+                             sorted(names[1:]))
+        self.assertIn('sockets', ret['sockstat'])
+        self.assertIn('TCP', ret['sockstat'])
+
+    def test_parse(self):
+        tdir = tempfile.mkdtemp()
+        try:
+            self.write_procfs(tdir, {
+                "snmp": """\
+                    Tcp: RtoAlgorithm MaxConn ActiveOpens
+                    Tcp: 1 -1 189
+                    Udp: InDatagrams
+                    Udp: 12
+                    """,
+                "netstat": """\
+                    TcpExt: SyncookiesSent
+                    TcpExt: 3
+                    """,
+                "snmp6": """\
+                    Ip6InReceives                   	5
+                    UdpLite6InDatagrams             	0
+                    Icmp6OutType133                 	2
+                    """,
+                "sockstat": """\
+                    sockets: used 18
+                    TCP: inuse 4 orphan 0 tw 2 alloc 4 mem 1
+                    """,
+                "sockstat6": """\
+                    TCP6: inuse 1
+                    """,
+            })
+            psutil.PROCFS_PATH = tdir
+            ret = psutil.net_proto_counters()
+        finally:
+            psutil.PROCFS_PATH = "/proc"
+            shutil.rmtree(tdir)
+        self.assertEqual(ret, {
+            'Tcp': {'RtoAlgorithm': 1, 'MaxConn': -1, 'ActiveOpens': 189},
+            'Udp': {'InDatagrams': 12},
+            'TcpExt': {'SyncookiesSent': 3},
+            'Ip6': {'InReceives': 5},
+            'UdpLite6': {'InDatagrams': 0},
+            'Icmp6': {'OutType133': 2},
+            'sockstat': {
+                'sockets': {'used': 18},
+                'TCP': {'inuse': 4, 'orphan': 0, 'tw': 2, 'alloc': 4,
+                        'mem': 1},
+                'TCP6': {'inuse': 1}}})
+
+    def test_missing_files(self):
+        # e.g. no IPv6 support
+        tdir = tempfile.mkdtemp()
+        try:
+            self.write_procfs(tdir, {})
+            psutil.PROCFS_PATH = tdir
+            self.assertEqual(psutil.net_proto_counters(), {'sockstat': {}})
+        finally:
+            psutil.PROCFS_PATH = "/proc"
+            shutil.rmtree(tdir)
+
+    def test_nowrap(self):
+        def counters(segs, estab):
+            return {'Tcp': {'InSegs': segs, 'CurrEstab': estab},
+                    'sockstat': {'TCP': {'inuse': estab}}}
+
+        with mock.patch("psutil._psplatform.net_proto_counters",
+                        return_value=counters(100, 5)):
+            psutil.net_proto_counters()
+        with mock.patch("psutil._psplatform.net_proto_counters",
+                        return_value=counters(10, 2)):
+            ret = psutil.net_proto_counters()
+        # counters keep increasing, gauges don't
+        self.assertEqual(ret, counters(110, 2))
+        with mock.patch("psutil._psplatform.net_proto_counters",
+                        return_value=counters(10, 2)):
+            ret = psutil.net_proto_counters(nowrap=False)
+        self.assertEqual(ret, counters(10, 2))
+
+
+@unittest.skipIf(not LINUX, "LINUX only")
+class TestSystemNetSoftnetStats(unittest.TestCase):
+
+    def test_against_cpu_times(self):
+        self.assertEqual(len(psutil.net_softnet_stats()),
+                         len(psutil.cpu_times(percpu=True)))
+
+    def test_parse(self):
+        # second row: kernel < 3.11 (no flow_limit_count)
+        content = (
+            b"0000a2f1 00000002 0000001f 00000000 00000000 00000000 "
+            b"00000000 00000000 00000003 00000010 00000001 00000000 "
+            b"00000000\n"
+            b"00000100 00000000 00000000 00000000 00000000 00000000 "
+            b"00000000 00000000 00000000 0000000a\n")
+        with mock_open_content('/proc/net/softnet_stat', content) as m:
+            ret = psutil.net_softnet_stats()
+            assert m.called
+        ssoftnet = psutil._pslinux.ssoftnet
+        self.assertEqual(ret, [
+            ssoftnet(processed=0xa2f1, dropped=2, time_squeeze=0x1f,
+                     cpu_collision=3, received_rps=0x10, flow_limit_count=1),
+            ssoftnet(processed=0x100, dropped=0, time_squeeze=0,
+                     cpu_collision=0, received_rps=10, flow_limit_count=0)])
+
 
 @unittest.skipIf(not LINUX, "LINUX only")
 class TestSystemNetConnections(unittest.TestCase):
 
+    def test_inet_diag_against_procfs(self):
+        cext = psutil._psplatform.cext
+        try:
+            cext.net_inet_diag(socket.AF_INET, socket.IPPROTO_TCP)
+        except OSError:
+            raise unittest.SkipTest("NETLINK_SOCK_DIAG not supported")
+        server, client = tcp_socketpair(socket.AF_INET)
+        self.addCleanup(server.close)
+        self.addCleanup(client.close)
+        with create_sockets():
+            for fun in (psutil.net_connections, psutil.Process().connections):
+                with mock.patch("psutil._pslinux.cext.net_inet_diag",
+                                side_effect=OSError) as m:
+                    procfs = fun(kind='inet')
+                    assert m.called
+                diag = fun(kind='inet')
+                self.assertEqual(sorted(diag), sorted(procfs))
+
+    def test_inet_diag(self):
+        cext = psutil._psplatform.cext
+        found = set()
+        with create_sockets() as socks:
+            inodes = set([str(os.fstat(s.fileno()).st_ino) for s in socks
+                          if s.family in (socket.AF_INET, socket.AF_INET6)])
+            for family in (socket.AF_INET, socket.AF_INET6):
+                for proto in (socket.IPPROTO_TCP, socket.IPPROTO_UDP):
+                    try:
+                        ls = cext.net_inet_diag(family, proto)
+                    except OSError:
+                        continue
+                    for inode, state, laddr, lport, raddr, rport in ls:
+                        self.assertIsInstance(laddr, str)
+                        self.assertIsInstance(raddr, str)
+                        assert 0 <= lport <= 65535, lport
+                        assert 0 <= rport <= 65535, rport
+                        assert 0 < state <= 12, state
+                        found.add(str(inode))
+        if not found:
+            raise unittest.SkipTest("NETLINK_SOCK_DIAG not supported")
+        self.assertEqual(inodes - found, set())
+
+    def test_inet_diag_filters(self):
+        # filters evaluated by the kernel must produce the same result
+        # as the ones applied while parsing /proc/net/*
+        cext = psutil._psplatform.cext
+        try:
+            cext.net_inet_diag(socket.AF_INET, socket.IPPROTO_TCP)
+        except OSError:
+            raise unittest.SkipTest("NETLINK_SOCK_DIAG not supported")
+        server, client = tcp_socketpair(socket.AF_INET)
+        self.addCleanup(server.close)
+        self.addCleanup(client.close)
+        port = server.getsockname()[1]
+        with create_sockets():
+            for kwargs in [
+                    dict(status=psutil.CONN_LISTEN),
+                    dict(status=[psutil.CONN_NONE, psutil.CONN_SYN_RECV]),
+                    dict(lport=port),
+                    dict(lport=(1, 1024), rport=(1024, 65535)),
+                    dict(rport=port, status=psutil.CONN_ESTABLISHED),
+                    dict(laddr="127.0.0.0/8"),
+                    dict(laddr="127.0.0.1", raddr="127.0.0.0/24"),
+                    dict(raddr="0.0.0.0/0"),
+                    dict(laddr="::/0", lport=(1, 65535)),
+                    dict(laddr="::ffff:0:0/96")]:
+                for fun in (psutil.net_connections,
+                            psutil.Process().connections):
+                    with mock.patch("psutil._pslinux.cext.net_inet_diag",
+                                    side_effect=OSError) as m:
+                        procfs = fun(kind='all', **kwargs)
+                        assert m.called
+                    diag = fun(kind='all', **kwargs)
+                    self.assertEqual(sorted(diag), sorted(procfs),
+                                     msg=kwargs)
+
+    def test_inet_diag_bytecode(self):
+        flt = psutil._common.ConnFilter(lport=(1, 1024), raddr="10.0.0.0/8")
+        bc = psutil._pslinux.Connections.inet_diag_bytecode(flt)
+        # S_GE + S_LE (8 bytes each) + D_COND (op + hostcond + addr)
+        self.assertEqual(len(bc), 8 + 8 + 4 + 8 + 4)
+        code, yes, no = struct.unpack("=BBH", bc[:4])
+        self.assertEqual((code, yes, no), (2, 8, len(bc) + 4))
+        code, yes, no = struct.unpack("=BBH", bc[16:20])
+        self.assertEqual((code, yes, no), (8, 16, 16 + 4))
+        self.assertEqual(bc[-4:], socket.inet_aton("10.0.0.0"))
+        self.assertEqual(
+            psutil._pslinux.Connections.inet_diag_bytecode(None), b"")
+        # no TCP state is set for UDP-only filters
+        flt = psutil._common.ConnFilter(status=psutil.CONN_NONE)
+        self.assertEqual(
+            psutil._pslinux.Connections.inet_diag_states(flt), 0)
+
+    def test_details(self):
+        server, client = tcp_socketpair(socket.AF_INET)
+        self.addCleanup(server.close)
+        self.addCleanup(client.close)
+        client.sendall(b"x" * 1000)
+        # wait for data to be queued on the receiving side
+        call_until(lambda: select.select([server], [], [], 0)[0], "ret")
+        port = server.getsockname()[1]
+        cons = psutil.Process().connections(kind='tcp4', lport=port,
+                                            details=True)
+        self.assertEqual(len(cons), 1)
+        conn = cons[0]
+        self.assertEqual(conn._fields[:6], psutil._common.pconn._fields)
+        self.assertEqual(conn.recv_queue, 1000)
+        self.assertEqual(conn.send_queue, 0)
+        cons = psutil.net_connections(kind='tcp4', rport=port,
+                                      details=True)
+        self.assertEqual(len(cons), 1)
+        conn = cons[0]
+        self.assertEqual(conn.pid, os.getpid())
+        self.assertEqual(conn.recv_queue, 0)
+        self.assertEqual(conn.send_queue, 0)
+        if conn.rtt is not None:  # not retrieved via sock_diag
+            self.assertIsInstance(conn.rtt, float)
+            assert 0 <= conn.rtt < 10, conn.rtt
+            self.assertGreater(conn.cwnd, 0)
+            self.assertEqual(conn.retransmits, 0)
+            self.assertEqual(conn.unacked, 0)
+
+    def test_details_against_procfs(self):
+        server, client = tcp_socketpair(socket.AF_INET)
+        self.addCleanup(server.close)
+        self.addCleanup(client.close)
+        client.sendall(b"x" * 1000)
+        call_until(lambda: select.select([server], [], [], 0)[0], "ret")
+        with create_sockets():
+            with mock.patch("psutil._pslinux.cext.net_inet_diag",
+                            side_effect=OSError) as m:
+                procfs = psutil.Process().connections(kind='all',
+                                                      details=True)
+                assert m.called
+            diag = psutil.Process().connections(kind='all', details=True)
+        self.assertEqual(sorted([x[:8] for x in diag]),
+                         sorted([x[:8] for x in procfs]))
+        for conn in procfs:
+            self.assertEqual(conn[8:], (None, None, None, None))
+
+    def test_unix_diag_peers(self):
+        cext = psutil._psplatform.cext
+        try:
+            cext.net_unix_diag()
+        except OSError:
+            raise unittest.SkipTest("UNIX_DIAG not supported")
+        with unix_socket_path() as name:
+            server, client = unix_socketpair(name)
+            self.addCleanup(server.close)
+            self.addCleanup(client.close)
+            server.setblocking(1)
+            conn, _ = server.accept()
+            self.addCleanup(conn.close)
+            client.sendall(b"x" * 100)
+            fds = dict([(x.fd, x) for x in psutil.Process().connections(
+                kind='unix', details=True)])
+            # listening socket
+            self.assertEqual(fds[server.fileno()].laddr, name)
+            self.assertEqual(fds[server.fileno()].raddr, "")
+            # accepted socket; the client has no path
+            self.assertEqual(fds[conn.fileno()].laddr, name)
+            self.assertEqual(fds[conn.fileno()].raddr, "")
+            self.assertEqual(fds[conn.fileno()].recv_queue, 100)
+            # the client is connected to the path of the server
+            self.assertEqual(fds[client.fileno()].laddr, "")
+            self.assertEqual(fds[client.fileno()].raddr, name)
+            self.assertEqual(fds[client.fileno()].recv_queue, 0)
+
+    def test_unix_diag_against_procfs(self):
+        cext = psutil._psplatform.cext
+        try:
+            cext.net_unix_diag()
+        except OSError:
+            raise unittest.SkipTest("UNIX_DIAG not supported")
+        with create_sockets():
+            for fun in (psutil.net_connections, psutil.Process().connections):
+                with mock.patch("psutil._pslinux.cext.net_unix_diag",
+                                side_effect=OSError) as m:
+                    procfs = fun(kind='unix')
+                    assert m.called
+                diag = fun(kind='unix')
+                if fun is psutil.net_connections:
+                    # only compare the sockets of this process; the
+                    # not accepted ones are listed in /proc/net/unix
+                    # only
+                    procfs = [x for x in procfs if x.pid == os.getpid()]
+                    diag = [x for x in diag if x.pid == os.getpid()]
+                # raddr is never set when parsing /proc/net/unix
+                self.assertEqual(
+                    sorted([x[:4] + x[5:] for x in diag]),
+                    sorted([x[:4] + x[5:] for x in procfs]))
+
+    def test_socket_inodes(self):
+        cext = psutil._psplatform.cext
+        conns = psutil._pslinux._connections
+        conns._procfs_path = "/proc"
+        with create_sockets() as socks:
+            mine = conns.get_proc_inodes(os.getpid())
+            self.assertGreaterEqual(len(mine), len(socks))
+            inodes = cext.proc_socket_inodes("/proc")
+            for sock in socks:
+                # not inherited, hence not shared with other processes
+                inode = str(os.fstat(sock.fileno()).st_ino)
+                self.assertEqual(inodes[inode], mine[inode])
+            for inode, pairs in inodes.items():
+                self.assertIsInstance(inode, str)
+                for pid, fd in pairs:
+                    self.assertEqual(pid, pairs[0][0])
+                    self.assertGreaterEqual(fd, 0)
+            # only resolve the wanted ones
+            wanted = [int(x) for x in list(mine)[:2]]
+            ret = cext.proc_socket_inodes("/proc", wanted)
+            self.assertEqual(sorted(ret), sorted([str(x) for x in wanted]))
+            self.assertEqual(cext.proc_socket_inodes("/proc", []), {})
+            self.assertEqual(cext.proc_socket_inodes("/proc", [0]), {})
+
+    def test_socket_inodes_dup(self):
+        # all the fds referencing the same socket are listed
+        sock = bind_socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.addCleanup(sock.close)
+        fd = os.dup(sock.fileno())
+        self.addCleanup(os.close, fd)
+        inode = str(os.fstat(fd).st_ino)
+        inodes = psutil._psplatform.cext.proc_socket_inodes("/proc")
+        self.assertEqual(sorted(inodes[inode]),
+                         sorted([(os.getpid(), sock.fileno()),
+                                 (os.getpid(), fd)]))
+
+    def test_inet_diag_custom_procfs_path(self):
+        # netlink can't be used to inspect a different /proc
+        with mock.patch("psutil._pslinux.get_procfs_path",
+                        return_value="/proc/self/../"):
+            with mock.patch("psutil._pslinux.cext.net_inet_diag") as m:
+                psutil.net_connections(kind='inet')
+                assert not m.called
+
+    @mock.patch('psutil._pslinux.cext.net_inet_diag', side_effect=OSError)
     @mock.patch('psutil._pslinux.socket.inet_ntop', side_effect=ValueError)
     @mock.patch('psutil._pslinux.supports_ipv6', return_value=False)
-    def test_emulate_ipv6_unsupported(self, supports_ipv6, inet_ntop):
+    def test_emulate_ipv6_unsupported(self, supports_ipv6, inet_ntop, diag):
         # see: https://github.com/giampaolo/psutil/issues/623
         try:
             s = socket.socket(socket.AF_INET6, socket.SOCK_STREAM)
@@ -964,7 +1820,8 @@ class TestSystemNetConnections(unittest.TestCase):
             pass
         psutil.net_connections(kind='inet6')
 
-    def test_emulate_unix(self):
+    @mock.patch('psutil._pslinux.cext.net_unix_diag', side_effect=OSError)
+    def test_emulate_unix(self, diag):
         with mock_open_content(
             '/proc/net/unix',
             textwrap.dedent("""\
@@ -977,6 +1834,83 @@ class TestSystemNetConnections(unittest.TestCase):
             assert m.called
 
 
+@unittest.skipIf(not LINUX, "LINUX only")
+@unittest.skipIf(not which("unshare"), "unshare utility not available")
+class TestSystemNetNamespace(unittest.TestCase):
+    """Tests for the netns_pid parameter, run against a process
+    listening on a TCP socket in a new network namespace.
+    """
+
+    @classmethod
+    def setUpClass(cls):
+        src = textwrap.dedent("""\
+            import socket, time
+            s = socket.socket()
+            s.bind(('127.0.0.1', 0))
+            s.listen(5)
+            with open(%r, 'w') as f:
+                f.write(str(s.getsockname()[1]))
+            time.sleep(60)
+            """ % TESTFN)
+        safe_rmpath(TESTFN)
+        cls.proc = get_test_subprocess(
+            ["unshare", "-n", PYTHON_EXE, "-c", src], stderr=DEVNULL)
+        try:
+            cls.port = int(wait_for_file(TESTFN))
+        except Exception:
+            cls.port = None
+
+    @classmethod
+    def tearDownClass(cls):
+        reap_children()
+
+    def setUp(self):
+        if self.port is None:
+            raise unittest.SkipTest("can't create a network namespace")
+
+    def test_io_counters(self):
+        nio = psutil.net_io_counters(pernic=True, netns_pid=self.proc.pid)
+        self.assertEqual(list(nio.keys()), ['lo'])
+        with mock.patch("psutil._pslinux.cext.net_io_counters",
+                        side_effect=OSError) as m:
+            procfs = psutil.net_io_counters(pernic=True,
+                                            netns_pid=self.proc.pid)
+            assert m.called
+        self.assertEqual(list(procfs.keys()), ['lo'])
+        # our own namespace
+        self.assertEqual(
+            sorted(psutil.net_io_counters(pernic=True,
+                                          netns_pid=os.getpid()).keys()),
+            sorted(psutil.net_io_counters(pernic=True).keys()))
+
+    def test_connections(self):
+        def check(cons):
+            self.assertEqual(len(cons), 1, msg=cons)
+            conn = cons[0]
+            self.assertEqual(conn.laddr, ('127.0.0.1', self.port))
+            self.assertEqual(conn.status, psutil.CONN_LISTEN)
+            self.assertEqual(conn.pid, self.proc.pid)
+
+        check(psutil.net_connections(kind='tcp4', netns_pid=self.proc.pid))
+        check(psutil.net_connections(kind='tcp4', netns_pid=self.proc.pid,
+                                     lport=self.port))
+        with mock.patch("psutil._pslinux.open_netns",
+                        return_value=None) as m:
+            check(psutil.net_connections(kind='tcp4',
+                                         netns_pid=self.proc.pid))
+            assert m.called
+        # not visible from our namespace
+        for conn in psutil.net_connections(kind='tcp4'):
+            self.assertNotEqual(conn.pid, self.proc.pid)
+
+    def test_no_such_process(self):
+        pid = max(psutil.pids()) + 5000
+        self.assertRaises(psutil.NoSuchProcess, psutil.net_io_counters,
+                          netns_pid=pid)
+        self.assertRaises(psutil.NoSuchProcess, psutil.net_connections,
+                          netns_pid=pid)
+
+
 # =====================================================================
 # --- system disks
 # =====================================================================
@@ -1370,6 +2304,349 @@ class TestMisc(unittest.TestCase):
             assert psutil.pid_exists(os.getpid())
             assert m.called
 
+    def test_proc_stat_scan(self):
+        ls = psutil._pslinux.proc_stat_scan()
+        pids = [x[0] for x in ls]
+        self.assertEqual(len(pids), len(set(pids)))
+        self.assertIn(os.getpid(), pids)
+        entry = [x for x in ls if x[0] == os.getpid()][0]
+        p = psutil.Process()
+        self.assertEqual(entry[1], os.getppid())
+        self.assertEqual(entry[1], p.ppid())
+        self.assertEqual(entry[9], p.num_threads())
+        if hasattr(p, "cpu_num"):
+            self.assertIn(entry[10], range(psutil.cpu_count()))
+
+    def test_proc_stat_scan_procfs_path(self):
+        tdir = tempfile.mkdtemp()
+        try:
+            psutil.PROCFS_PATH = tdir
+            self.assertEqual(psutil._pslinux.proc_stat_scan(), [])
+            psutil.PROCFS_PATH = os.path.join(tdir, "foo")
+            self.assertRaises(OSError, psutil._pslinux.proc_stat_scan)
+        finally:
+            psutil.PROCFS_PATH = "/proc"
+            os.rmdir(tdir)
+
+    def test_proc_counters_map(self):
+        counters = psutil._pslinux.proc_counters_map()
+        p = psutil.Process()
+        with p.oneshot():
+            ctime = p.create_time()
+            cpu_times = p.cpu_times()
+            io = p.io_counters()
+            ctx = p.num_ctx_switches()
+        (ident, cpu_time, read_bytes, write_bytes, ctx_switches,
+            minflt, majflt) = counters[os.getpid()]
+        self.assertAlmostEqual(
+            ident / psutil._pslinux.CLOCK_TICKS + psutil.boot_time(),
+            ctime, delta=1)
+        self.assertAlmostEqual(cpu_time, cpu_times.user + cpu_times.system,
+                               delta=0.1)
+        self.assertAlmostEqual(read_bytes, io.read_bytes, delta=1024 * 1024)
+        self.assertAlmostEqual(write_bytes, io.write_bytes,
+                               delta=1024 * 1024)
+        self.assertAlmostEqual(ctx_switches, ctx.voluntary + ctx.involuntary,
+                               delta=50)
+        self.assertGreater(minflt, 0)
+        self.assertGreaterEqual(majflt, 0)
+
+    def test_ppid_map(self):
+        self.assertEqual(psutil._pslinux.ppid_map()[os.getpid()],
+                         os.getppid())
+
+    def test_create_time_map(self):
+        ctimes = psutil._pslinux.create_time_map()
+        self.assertEqual(ctimes[os.getpid()], psutil.Process().create_time())
+
+
+@unittest.skipIf(not LINUX, "LINUX only")
+class TestPidsTracker(unittest.TestCase):
+
+    def tearDown(self):
+        reap_children()
+
+    def test_pids_tracker(self):
+        tracker = psutil._pslinux.pids_tracker()
+        if tracker is None:
+            raise self.skipTest("proc connector not available")
+        token, current, started, exited = tracker.changes(None)
+        self.assertIsNone(started)
+        self.assertIsNone(exited)
+        self.assertIn(os.getpid(), current)
+        sproc = get_test_subprocess()
+        token, current, started, exited = tracker.changes(token)
+        self.assertIn(sproc.pid, current)
+        self.assertIn(sproc.pid, started)
+        # short-lived process
+        pid = sh([PYTHON_EXE, "-c", "import os; print(os.getpid())"])
+        token2, current, started, exited = tracker.changes(token)
+        self.assertIn(int(pid), started)
+        self.assertIn(int(pid), exited)
+        self.assertNotIn(int(pid), current)
+        # unknown / lost history
+        self.assertIsNone(tracker.changes((-1, 0))[2])
+        tracker._log.clear()
+        self.assertIsNone(tracker.changes((token2[0], token2[1] - 1))[2])
+
+    def test_pids_tracker_enobufs(self):
+        tracker = psutil._pslinux.pids_tracker()
+        if tracker is None:
+            raise self.skipTest("proc connector not available")
+        token = tracker.changes(None)[0]
+        exc = OSError(errno.ENOBUFS, "")
+        with mock.patch("psutil._pslinux.cext.proc_events_read",
+                        side_effect=[exc, []]) as m:
+            newtoken, current, started, exited = tracker.changes(token)
+            self.assertEqual(m.call_count, 2)
+        self.assertNotEqual(newtoken[0], token[0])
+        self.assertIsNone(exited)
+        self.assertIn(os.getpid(), current)
+
+    def test_pids_tracker_procfs_path(self):
+        psutil.PROCFS_PATH = "/foo"
+        try:
+            self.assertIsNone(psutil._pslinux.pids_tracker())
+        finally:
+            psutil.PROCFS_PATH = "/proc"
+
+
+def _has_pidfd():
+    try:
+        os.close(psutil._psplatform.cext.proc_pidfd_open(os.getpid()))
+    except OSError:
+        return False
+    return True
+
+
+HAS_PIDFD = LINUX and _has_pidfd()
+
+
+@unittest.skipIf(not LINUX, "LINUX only")
+class TestWaitPidfd(unittest.TestCase):
+
+    def tearDown(self):
+        reap_children()
+
+    @unittest.skipIf(not HAS_PIDFD, "pidfd_open() not supported")
+    def test_wait(self):
+        sproc = get_test_subprocess()
+        p = psutil.Process(sproc.pid)
+        with mock.patch("psutil._psposix.wait_pid") as m:
+            self.assertRaises(psutil.TimeoutExpired, p.wait, 0.01)
+            p.terminate()
+            self.assertEqual(p.wait(), -signal.SIGTERM)
+            assert not m.called
+
+    def test_wait_enosys(self):
+        sproc = get_test_subprocess()
+        p = psutil.Process(sproc.pid)
+        exc = OSError(errno.ENOSYS, "")
+        with mock.patch("psutil._pslinux.cext.proc_pidfd_open",
+                        side_effect=exc) as m:
+            self.assertRaises(psutil.TimeoutExpired, p.wait, 0.01)
+            p.terminate()
+            self.assertEqual(p.wait(), -signal.SIGTERM)
+            assert m.called
+
+    @unittest.skipIf(not HAS_PIDFD, "pidfd_open() not supported")
+    def test_pids_waiter(self):
+        sproc1 = get_test_subprocess()
+        sproc2 = get_test_subprocess()
+        waiter = psutil._pslinux.PidsWaiter([sproc1.pid, sproc2.pid])
+        self.addCleanup(waiter.close)
+        self.assertEqual(waiter.wait(0.01), set())
+        sproc2.terminate()
+        self.assertEqual(waiter.wait(), set([sproc2.pid]))
+        # its pidfd was closed
+        self.assertEqual(list(waiter.fds.values()), [sproc1.pid])
+        self.assertEqual(len(waiter), 1)
+        self.assertEqual(waiter.wait(0.01), set())
+        waiter.close()
+        self.assertEqual(len(waiter), 0)
+        # no such process
+        sproc2.wait()
+        waiter = psutil._pslinux.PidsWaiter([sproc2.pid])
+        self.assertEqual(waiter.wait(), set([sproc2.pid]))
+
+    def test_pids_waiter_emfile(self):
+        sproc1 = get_test_subprocess()
+        sproc2 = get_test_subprocess()
+        exc = OSError(errno.EMFILE, "")
+        with mock.patch("psutil._pslinux.cext.proc_pidfd_open",
+                        side_effect=exc):
+            waiter = psutil._pslinux.PidsWaiter([sproc1.pid, sproc2.pid])
+            self.assertEqual(waiter.wait(0.01), set())
+        self.assertEqual(waiter.unwatched, set([sproc1.pid, sproc2.pid]))
+
+    @unittest.skipIf(not HAS_PIDFD, "pidfd_open() not supported")
+    def test_wait_procs_pidfds_opened_once(self):
+        # Waiting for N processes terminating one at a time opens N
+        # pidfds overall, not one per process per wakeup.
+        procs = [psutil.Process(get_test_subprocess().pid)
+                 for x in range(4)]
+        to_kill = iter(procs[1:])
+
+        def on_terminate(proc):
+            # terminate the next one
+            for p in to_kill:
+                p.terminate()
+                break
+
+        with mock.patch("psutil._pslinux.cext.proc_pidfd_open",
+                        wraps=psutil._pslinux.cext.proc_pidfd_open) as m:
+            procs[0].terminate()
+            gone, alive = psutil.wait_procs(procs, timeout=GLOBAL_TIMEOUT,
+                                            callback=on_terminate)
+        self.assertEqual(alive, [])
+        self.assertEqual(m.call_count, len(procs))
+
+    def test_wait_procs_enosys(self):
+        procs = [psutil.Process(get_test_subprocess().pid),
+                 psutil.Process(get_test_subprocess().pid)]
+        exc = OSError(errno.ENOSYS, "")
+        with mock.patch("psutil._pslinux.cext.proc_pidfd_open",
+                        side_effect=exc) as m:
+            gone, alive = psutil.wait_procs(procs, timeout=0.01)
+            self.assertEqual(len(alive), 2)
+            procs[0].terminate()
+            gone, alive = psutil.wait_procs(procs, timeout=3)
+            self.assertEqual(gone, [procs[0]])
+            assert m.called
+
+
+@unittest.skipIf(not LINUX, "LINUX only")
+@unittest.skipIf(not HAS_PIDFD, "pidfd_open() not supported")
+class TestProcessPidfd(unittest.TestCase):
+
+    def tearDown(self):
+        reap_children()
+
+    def test_is_running(self):
+        p = psutil.Process(get_test_subprocess().pid, pidfd=True)
+        assert p._pidfd
+        # no need to check process identity
+        with mock.patch("psutil._pslinux.Process.create_time") as m:
+            assert p.is_running()
+            assert not m.called
+        p.terminate()
+        p.wait()
+        assert not p.is_running()
+
+    def test_zombie(self):
+        # a terminated process is still running until it's reaped
+        sproc = get_test_subprocess()
+        p = psutil.Process(sproc.pid, pidfd=True)
+        p.kill()
+        call_until(p.status, "ret == psutil.STATUS_ZOMBIE")
+        assert p.is_running()
+        sproc.wait()
+        assert not p.is_running()
+
+    def test_send_signal(self):
+        p = psutil.Process(get_test_subprocess().pid, pidfd=True)
+        with mock.patch("psutil.os.kill") as m:
+            p.terminate()
+            assert not m.called
+        self.assertEqual(p.wait(), -signal.SIGTERM)
+        self.assertRaises(psutil.NoSuchProcess, p.kill)
+        # reaped: the signal can't reach a process reusing the PID
+        with self.assertRaises(OSError) as cm:
+            p._proc.pidfd_send_signal(signal.SIGKILL)
+        self.assertEqual(cm.exception.errno, errno.ESRCH)
+
+    def test_not_supported(self):
+        sproc = get_test_subprocess()
+        exc = OSError(errno.ENOSYS, "")
+        with mock.patch("psutil._pslinux.cext.proc_pidfd_open",
+                        side_effect=exc) as m:
+            p = psutil.Process(sproc.pid, pidfd=True)
+            assert m.called
+        assert not p._pidfd
+        assert p.is_running()
+        p.terminate()
+        self.assertEqual(p.wait(), -signal.SIGTERM)
+
+    def test_fd_closed(self):
+        p = psutil.Process(pidfd=True)
+        fd = p._proc._pidfd
+        os.fstat(fd)
+        del p
+        with self.assertRaises(OSError) as cm:
+            os.fstat(fd)
+        self.assertEqual(cm.exception.errno, errno.EBADF)
+
+
+@unittest.skipIf(not LINUX, "LINUX only")
+class TestProcessWatch(unittest.TestCase):
+
+    def tearDown(self):
+        reap_children()
+
+    def test_pread(self):
+        p = psutil.Process(get_test_subprocess().pid, watch=True)
+        q = psutil.Process(p.pid)
+        assert p._proc._watched
+        expected = (q.name(), q.ppid(), q.memory_info(), q.num_threads())
+        with mock.patch("psutil._pslinux.open_binary",
+                        side_effect=AssertionError) as m:
+            self.assertEqual(
+                (p.name(), p.ppid(), p.memory_info(), p.num_threads()),
+                expected)
+            p.cpu_times()
+            p.num_ctx_switches()
+            p.io_counters()
+            assert p.is_running()
+            assert not m.called
+
+    def test_gone(self):
+        sproc = get_test_subprocess()
+        p = psutil.Process(sproc.pid, watch=True)
+        p.kill()
+        call_until(p.status, "ret == psutil.STATUS_ZOMBIE")
+        assert p.is_running()
+        sproc.wait()
+        # the same goes for a new process reusing the PID
+        with mock.patch("psutil._pslinux.open_binary",
+                        side_effect=AssertionError):
+            self.assertRaises(psutil.NoSuchProcess, p.memory_info)
+            assert not p.is_running()
+
+    def test_access_denied(self):
+        # files we can't open are read as usual
+        exc = OSError(errno.EACCES, "")
+        fds = psutil._psplatform.cext.proc_watch_open(
+            "/proc/%s" % os.getpid(), ("stat", "io"))
+        try:
+            with mock.patch("psutil._pslinux.cext.proc_watch_open",
+                            return_value=(fds[0], [fds[1][0], -1])):
+                p = psutil.Process(watch=True)
+            self.assertEqual(sorted(p._proc._watched), ["stat"])
+            with mock.patch("psutil._pslinux.open_binary",
+                            side_effect=exc):
+                self.assertRaises(psutil.AccessDenied, p.io_counters)
+        finally:
+            os.close(fds[1][1])
+
+    def test_fds_closed(self):
+        p = psutil.Process(watch=True)
+        fds = [p._proc._dirfd] + list(p._proc._watched.values())
+        del p
+        for fd in fds:
+            with self.assertRaises(OSError) as cm:
+                os.fstat(fd)
+            self.assertEqual(cm.exception.errno, errno.EBADF)
+
+    def test_procfs_path(self):
+        tdir = tempfile.mkdtemp()
+        try:
+            psutil.PROCFS_PATH = tdir
+            self.assertRaises(psutil.NoSuchProcess, psutil.Process,
+                              watch=True)
+        finally:
+            psutil.PROCFS_PATH = "/proc"
+            os.rmdir(tdir)
+
 
 # =====================================================================
 # --- sensors
@@ -1525,111 +2802,162 @@ class TestSensorsBattery(unittest.TestCase):
                     self.assertIsNone(psutil.sensors_battery().power_plugged)
 
 
+@contextlib.contextmanager
+def fake_sys_class(files):
+    """Same as fake_sysfs() (a /sys/class tree) but also make
+    sensors_temperatures() and sensors_fans() read it; yield the
+    reader.
+    """
+    with fake_sysfs(files) as tdir:
+        reader = psutil._pslinux.SensorReader(tdir)
+        try:
+            with mock.patch("psutil._pslinux._sensor_reader", reader):
+                yield reader
+        finally:
+            reader.close()
+
+
 @unittest.skipIf(not LINUX, "LINUX only")
 class TestSensorsTemperatures(unittest.TestCase):
 
-    @unittest.skipIf(TRAVIS, "unreliable on TRAVIS")
-    def test_emulate_eio_error(self):
-        def open_mock(name, *args, **kwargs):
-            if name.endswith("_input"):
-                raise OSError(errno.EIO, "")
-            elif name.endswith("temp"):
-                raise OSError(errno.EIO, "")
-            else:
-                return orig_open(name, *args, **kwargs)
+    HWMON = {
+        "hwmon/hwmon0/name": "name\n",
+        "hwmon/hwmon0/temp1_label": "label\n",
+        "hwmon/hwmon0/temp1_input": "30000\n",
+        "hwmon/hwmon0/temp1_max": "40000\n",
+        "hwmon/hwmon0/temp1_crit": "50000\n",
+    }
 
-        orig_open = open
-        patch_point = 'builtins.open' if PY3 else '__builtin__.open'
-        with mock.patch(patch_point, side_effect=open_mock) as m:
-            with warnings.catch_warnings(record=True) as ws:
-                self.assertEqual(psutil.sensors_temperatures(), {})
-                assert m.called
-                self.assertIn("ignoring", str(ws[0].message))
+    def test_emulate_eio_error(self):
+        with fake_sys_class(self.HWMON):
+            with mock.patch("psutil._psutil_linux.sysfs_read",
+                            return_value=[None]) as m:
+                with warnings.catch_warnings(record=True) as ws:
+                    warnings.simplefilter("always")
+                    self.assertEqual(psutil.sensors_temperatures(), {})
+                    assert m.called
+                    self.assertIn("ignoring", str(ws[0].message))
+
+    def test_emulate_eio_error_no_rescan(self):
+        # A sensor which always fails doesn't make sensors be
+        # enumerated again on every call.
+        with fake_sys_class(self.HWMON):
+            with mock.patch("psutil._psutil_linux.sysfs_read",
+                            return_value=[None]):
+                with mock.patch("psutil._psutil_linux.sysfs_open",
+                                wraps=psutil._psutil_linux.sysfs_open) as m:
+                    with warnings.catch_warnings(record=True):
+                        warnings.simplefilter("always")
+                        psutil.sensors_temperatures()
+                        psutil.sensors_temperatures()
+                    self.assertEqual(m.call_count, 1)
 
     def test_emulate_class_hwmon(self):
-        def open_mock(name, *args, **kwargs):
-            if name.endswith('/name'):
-                return io.StringIO(u("name"))
-            elif name.endswith('/temp1_label'):
-                return io.StringIO(u("label"))
-            elif name.endswith('/temp1_input'):
-                return io.BytesIO(b"30000")
-            elif name.endswith('/temp1_max'):
-                return io.BytesIO(b"40000")
-            elif name.endswith('/temp1_crit'):
-                return io.BytesIO(b"50000")
-            else:
-                return orig_open(name, *args, **kwargs)
-
-        orig_open = open
-        patch_point = 'builtins.open' if PY3 else '__builtin__.open'
-        with mock.patch(patch_point, side_effect=open_mock):
-            # Test case with /sys/class/hwmon
-            with mock.patch('glob.glob',
-                            return_value=['/sys/class/hwmon/hwmon0/temp1']):
-                temp = psutil.sensors_temperatures()['name'][0]
-                self.assertEqual(temp.label, 'label')
-                self.assertEqual(temp.current, 30.0)
-                self.assertEqual(temp.high, 40.0)
-                self.assertEqual(temp.critical, 50.0)
+        with fake_sys_class(self.HWMON):
+            temp = psutil.sensors_temperatures()['name'][0]
+            self.assertEqual(temp.label, 'label')
+            self.assertEqual(temp.current, 30.0)
+            self.assertEqual(temp.high, 40.0)
+            self.assertEqual(temp.critical, 50.0)
+
+    def test_emulate_class_hwmon_device(self):
+        # CentOS has an intermediate /device directory.
+        files = {
+            "hwmon/hwmon0/device/name": "name\n",
+            "hwmon/hwmon0/device/temp1_input": "30000\n",
+        }
+        with fake_sys_class(files):
+            temp = psutil.sensors_temperatures()['name'][0]
+            self.assertEqual(temp.label, '')
+            self.assertEqual(temp.current, 30.0)
+            self.assertIsNone(temp.high)
+            self.assertIsNone(temp.critical)
+
+    def test_emulate_negative(self):
+        files = dict(self.HWMON)
+        files["hwmon/hwmon0/temp1_input"] = "-5500\n"
+        with fake_sys_class(files):
+            temp = psutil.sensors_temperatures()['name'][0]
+            self.assertEqual(temp.current, -5.5)
 
     def test_emulate_class_thermal(self):
-        def open_mock(name, *args, **kwargs):
-            if name.endswith('0_temp'):
-                return io.BytesIO(b"50000")
-            elif name.endswith('temp'):
-                return io.BytesIO(b"30000")
-            elif name.endswith('0_type'):
-                return io.StringIO(u("critical"))
-            elif name.endswith('type'):
-                return io.StringIO(u("name"))
-            else:
-                return orig_open(name, *args, **kwargs)
-
-        def glob_mock(path):
-            if path == '/sys/class/hwmon/hwmon*/temp*_*':
-                return []
-            elif path == '/sys/class/hwmon/hwmon*/device/temp*_*':
-                return []
-            elif path == '/sys/class/thermal/thermal_zone*':
-                return ['/sys/class/thermal/thermal_zone0']
-            elif path == '/sys/class/thermal/thermal_zone0/trip_point*':
-                return ['/sys/class/thermal/thermal_zone1/trip_point_0_type',
-                        '/sys/class/thermal/thermal_zone1/trip_point_0_temp']
-
-        orig_open = open
-        patch_point = 'builtins.open' if PY3 else '__builtin__.open'
-        with mock.patch(patch_point, side_effect=open_mock):
-            with mock.patch('glob.glob', create=True, side_effect=glob_mock):
+        files = {
+            "thermal/thermal_zone0/type": "name\n",
+            "thermal/thermal_zone0/temp": "30000\n",
+            "thermal/thermal_zone0/trip_point_0_type": "critical\n",
+            "thermal/thermal_zone0/trip_point_0_temp": "50000\n",
+            "thermal/thermal_zone0/trip_point_1_type": "high\n",
+            "thermal/thermal_zone0/trip_point_1_temp": "45000\n",
+        }
+        with fake_sys_class(files):
+            temp = psutil.sensors_temperatures()['name'][0]
+            self.assertEqual(temp.label, '')
+            self.assertEqual(temp.current, 30.0)
+            self.assertEqual(temp.high, 45.0)
+            self.assertEqual(temp.critical, 50.0)
+
+    def test_emulate_cached_attrs(self):
+        # Static attributes are read once; after that only the *_input
+        # files are re-read, from the fds kept open.
+        with fake_sys_class(self.HWMON) as reader:
+            psutil.sensors_temperatures()
+            write_files(reader.path, {
+                "hwmon/hwmon0/temp1_input": "35000\n",
+                "hwmon/hwmon0/temp1_max": "99000\n"})
+            with mock.patch("glob.glob") as m:
                 temp = psutil.sensors_temperatures()['name'][0]
-                self.assertEqual(temp.label, '')
-                self.assertEqual(temp.current, 30.0)
-                self.assertEqual(temp.high, 50.0)
-                self.assertEqual(temp.critical, 50.0)
+                assert not m.called
+            self.assertEqual(temp.current, 35.0)
+            self.assertEqual(temp.high, 40.0)
+
+    def test_emulate_rescan(self):
+        # A new hwmon device makes sensors be enumerated again.
+        with fake_sys_class(self.HWMON) as reader:
+            self.assertEqual(list(psutil.sensors_temperatures()), ['name'])
+            write_files(reader.path, {
+                "hwmon/hwmon1/name": "name2\n",
+                "hwmon/hwmon1/temp1_input": "60000\n"})
+            temps = psutil.sensors_temperatures()
+            self.assertEqual(sorted(temps), ['name', 'name2'])
+            self.assertEqual(temps['name2'][0].current, 60.0)
+
+    def test_emulate_driver_reload(self):
+        # A read error on a kept open fd (e.g. ENODEV after the driver
+        # was reloaded) makes sensors be enumerated again.
+        sysfs_read = psutil._psutil_linux.sysfs_read
+        results = [[None]]
+
+        def fake_sysfs_read(fds):
+            return results.pop() if results else sysfs_read(fds)
+
+        with fake_sys_class(self.HWMON) as reader:
+            psutil.sensors_temperatures()
+            write_files(reader.path, {"hwmon/hwmon0/temp1_input": "35000\n"})
+            with mock.patch("psutil._psutil_linux.sysfs_read",
+                            side_effect=fake_sysfs_read):
+                with mock.patch("psutil._psutil_linux.sysfs_open",
+                                wraps=psutil._psutil_linux.sysfs_open) as m:
+                    with warnings.catch_warnings(record=True) as ws:
+                        warnings.simplefilter("always")
+                        temp = psutil.sensors_temperatures()['name'][0]
+                    assert m.called
+            self.assertEqual(ws, [])
+            self.assertEqual(temp.current, 35.0)
 
 
 @unittest.skipIf(not LINUX, "LINUX only")
 class TestSensorsFans(unittest.TestCase):
 
     def test_emulate_data(self):
-        def open_mock(name, *args, **kwargs):
-            if name.endswith('/name'):
-                return io.StringIO(u("name"))
-            elif name.endswith('/fan1_label'):
-                return io.StringIO(u("label"))
-            elif name.endswith('/fan1_input'):
-                return io.StringIO(u("2000"))
-            else:
-                return orig_open(name, *args, **kwargs)
-
-        orig_open = open
-        patch_point = 'builtins.open' if PY3 else '__builtin__.open'
-        with mock.patch(patch_point, side_effect=open_mock):
-            with mock.patch('glob.glob',
-                            return_value=['/sys/class/hwmon/hwmon2/fan1']):
-                fan = psutil.sensors_fans()['name'][0]
-                self.assertEqual(fan.label, 'label')
-                self.assertEqual(fan.current, 2000)
+        files = {
+            "hwmon/hwmon2/name": "name\n",
+            "hwmon/hwmon2/fan1_label": "label\n",
+            "hwmon/hwmon2/fan1_input": "2000\n",
+        }
+        with fake_sys_class(files):
+            fan = psutil.sensors_fans()['name'][0]
+            self.assertEqual(fan.label, 'label')
+            self.assertEqual(fan.current, 2000)
 
 
 # =====================================================================
@@ -1661,17 +2989,19 @@ class TestProcess(unittest.TestCase):
         self.assertAlmostEqual(
             mem.uss, sum([x.private_dirty + x.private_clean for x in maps]),
             delta=4096)
+        # smaps_rollup's PSS is not rounded down to KB for every single
+        # mapping as smaps' one is.
         self.assertAlmostEqual(
-            mem.pss, sum([x.pss for x in maps]), delta=4096)
+            mem.pss, sum([x.pss for x in maps]), delta=4096 * len(maps))
         self.assertAlmostEqual(
             mem.swap, sum([x.swap for x in maps]), delta=4096)
 
     def test_memory_full_info_mocked(self):
         # See: https://github.com/giampaolo/psutil/issues/1222
         with mock_open_content(
-            "/proc/%s/smaps" % os.getpid(),
+            "/proc/%s/smaps_rollup" % os.getpid(),
             textwrap.dedent("""\
-                fffff0 r-xp 00000000 00:00 0                  [vsyscall]
+                fffff0 r-xp 00000000 00:00 0                  [rollup]
                 Size:                  1 kB
                 Rss:                   2 kB
                 Pss:                   3 kB
@@ -1693,13 +3023,115 @@ class TestProcess(unittest.TestCase):
                 Locked:                19 kB
                 VmFlags: rd ex
                 """).encode()) as m:
-            p = psutil.Process()
-            mem = p.memory_full_info()
+            with mock.patch("psutil._pslinux.HAS_SMAPS_ROLLUP", True):
+                p = psutil.Process()
+                mem = p.memory_full_info()
             assert m.called
             self.assertEqual(mem.uss, (6 + 7 + 14) * 1024)
             self.assertEqual(mem.pss, 3 * 1024)
             self.assertEqual(mem.swap, 15 * 1024)
 
+    def test_memory_full_info_no_rollup(self):
+        # Linux < 4.14: smaps is parsed in C.
+        fun = psutil._psplatform.cext.proc_smaps_totals
+        with mock.patch("psutil._pslinux.HAS_SMAPS_ROLLUP", False):
+            with mock.patch("psutil._pslinux.cext.proc_smaps_totals",
+                            wraps=fun) as m:
+                mem = psutil.Process().memory_full_info()
+                assert m.called
+        maps = psutil.Process().memory_maps(grouped=False)
+        self.assertAlmostEqual(
+            mem.uss, sum([x.private_dirty + x.private_clean for x in maps]),
+            delta=512 * 1024)
+        self.assertAlmostEqual(
+            mem.pss, sum([x.pss for x in maps]), delta=512 * 1024)
+        self.assertAlmostEqual(
+            mem.swap, sum([x.swap for x in maps]), delta=512 * 1024)
+
+    def test_memory_maps_iter(self):
+        self.addCleanup(reap_children)
+        p = psutil.Process(get_test_subprocess().pid)
+        self.assertEqual(sorted(p.memory_maps_iter()),
+                         sorted(p.memory_maps()))
+        self.assertEqual(list(p.memory_maps_iter(grouped=False)),
+                         p.memory_maps(grouped=False))
+
+    def test_memory_maps_iter_chunks(self):
+        # mappings spanning across chunks
+        self.addCleanup(reap_children)
+        p = psutil.Process(get_test_subprocess().pid)
+        expected = p.memory_maps(grouped=False)
+        with mock.patch("psutil._pslinux.Process._read_smaps_chunk",
+                        lambda self, f: f.read(100)):
+            self.assertEqual(list(p.memory_maps_iter(grouped=False)),
+                             expected)
+
+    def test_memory_maps_iter_filters(self):
+        self.addCleanup(reap_children)
+        p = psutil.Process(get_test_subprocess().pid)
+        maps = p.memory_maps(grouped=False)
+        self.assertEqual(
+            list(p.memory_maps_iter(grouped=False, path_filter="*.so*")),
+            [x for x in maps if fnmatch.fnmatch(x.path, "*.so*")])
+        self.assertEqual(
+            list(p.memory_maps_iter(grouped=False, perms="rx")),
+            [x for x in maps if 'r' in x.perms and 'x' in x.perms])
+        self.assertEqual(
+            list(p.memory_maps_iter(grouped=False, path_filter="[[]anon]",
+                                    perms="w")),
+            [x for x in maps if x.path == "[anon]" and 'w' in x.perms])
+        self.assertEqual(
+            list(p.memory_maps_iter(path_filter="/nonexistent/*")), [])
+
+    def test_memory_maps_iter_deleted(self):
+        # " (deleted)" suffix is stripped if the file doesn't exist
+        cext = psutil._psplatform.cext
+        data = textwrap.dedent("""\
+            7f0000-7f1000 r-xp 00000000 08:01 1   /foo/bar (deleted)
+            Rss:                   4 kB
+            7f1000-7f2000 r-xp 00000000 08:01 1   /foo/bar (deleted)
+            Rss:                   8 kB
+            """).encode()
+        consumed, ls = cext.proc_smaps_parse(data, 1, None, None, None)
+        self.assertEqual(consumed, len(data))
+        self.assertEqual([x[2] for x in ls], ["/foo/bar", "/foo/bar"])
+        groups = {}
+        cext.proc_smaps_parse(data, 1, "/foo/bar", None, groups)
+        self.assertEqual(groups, {"/foo/bar": [12288] + [0] * 9})
+
+    def test_memory_maps_iter_gone(self):
+        self.addCleanup(reap_children)
+        sproc = get_test_subprocess()
+        p = psutil.Process(sproc.pid)
+        sproc.terminate()
+        sproc.wait()
+        self.assertRaises(psutil.NoSuchProcess, p.memory_maps_iter)
+
+    def test_smaps_totals(self):
+        cext = psutil._psplatform.cext
+        # A mapping path longer than the C line buffer (256) is read
+        # in chunks, the second of which must not be parsed.
+        header = "00400000-0040b000 r-xp 00000000 08:01 1 /"
+        path = "x" * (255 - len(header)) + "Swap: 100"
+        with tempfile.NamedTemporaryFile() as f:
+            f.write(textwrap.dedent("""\
+                %s%s
+                Pss:                   1 kB
+                Private_Clean:         2 kB
+                Private_Dirty:         3 kB
+                Private_Hugetlb:       4 kB
+                Swap:                  5 kB
+                SwapPss:               6 kB
+                7f0000-7f1000 rw-p 00000000 00:00 0
+                Pss:                  10 kB
+                Private_Dirty:        20 kB
+                Swap:                 30 kB
+                """ % (header, path)).encode())
+            f.flush()
+            self.assertEqual(cext.proc_smaps_totals(f.name),
+                             (29 * 1024, 11 * 1024, 35 * 1024))
+        self.assertRaises(OSError, cext.proc_smaps_totals, f.name)
+
     # On PYPY file descriptors are not closed fast enough.
     @unittest.skipIf(PYPY, "unreliable on PYPY")
     def test_open_files_mode(self):
@@ -1773,6 +3205,30 @@ class TestProcess(unittest.TestCase):
                 assert not files
                 assert m.called
 
+    def test_oneshot_fd_listing(self):
+        # /proc/{pid}/fd is listed and resolved only once and shared
+        # by num_fds(), open_files() and connections().
+        p = psutil.Process()
+        with tempfile.NamedTemporaryFile() as f:
+            with contextlib.closing(socket.socket()) as sock:
+                sock.bind(("127.0.0.1", 0))
+                sock.listen(1)
+                sockfd = sock.fileno()
+                expected = (p.num_fds(), p.open_files(), p.connections())
+                with p.oneshot():
+                    with mock.patch("psutil._pslinux.os.listdir",
+                                    wraps=os.listdir) as m1:
+                        with mock.patch("psutil._pslinux.os.readlink",
+                                        wraps=os.readlink) as m2:
+                            self.assertEqual(
+                                (p.num_fds(), p.open_files(),
+                                 p.connections()),
+                                expected)
+                            self.assertEqual(m1.call_count, 1)
+                            self.assertEqual(m2.call_count, p.num_fds())
+        assert [x for x in expected[1] if x.path == f.name]
+        assert [x for x in expected[2] if x.fd == sockfd]
+
     # --- mocked tests
 
     def test_terminal_mocked(self):
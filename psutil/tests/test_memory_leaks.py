@@ -18,6 +18,7 @@ import errno
 import functools
 import gc
 import os
+import socket
 import sys
 import threading
 import time
@@ -35,10 +36,13 @@ from psutil.tests import create_sockets
 from psutil.tests import get_test_subprocess
 from psutil.tests import HAS_CPU_AFFINITY
 from psutil.tests import HAS_CPU_FREQ
+from psutil.tests import HAS_CPU_TOPOLOGY
 from psutil.tests import HAS_ENVIRON
 from psutil.tests import HAS_IONICE
 from psutil.tests import HAS_MEMORY_MAPS
 from psutil.tests import HAS_NET_IO_COUNTERS
+from psutil.tests import HAS_NET_PROTO_COUNTERS
+from psutil.tests import HAS_NET_SOFTNET_STATS
 from psutil.tests import HAS_PROC_CPU_NUM
 from psutil.tests import HAS_PROC_IO_COUNTERS
 from psutil.tests import HAS_RLIMIT
@@ -349,6 +353,12 @@ class TestProcessObjectLeaks(TestMemLeak):
     def test_memory_maps(self):
         self.execute(self.proc.memory_maps)
 
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_memory_maps_iter(self):
+        self.execute(lambda: list(self.proc.memory_maps_iter()))
+        self.execute(lambda: list(self.proc.memory_maps_iter(
+            grouped=False, path_filter="*.so*", perms="r")))
+
     @unittest.skipIf(not LINUX, "LINUX only")
     @unittest.skipIf(not HAS_RLIMIT, "not supported")
     def test_rlimit_get(self):
@@ -458,6 +468,7 @@ class TestModuleFunctionsLeaks(TestMemLeak):
     def test_coverage(self):
         skip = set((
             "version_info", "__version__", "process_iter", "wait_procs",
+            "process_table",
             "cpu_percent", "cpu_times_percent", "cpu_count"))
         for name in psutil.__all__:
             if not name.islower():
@@ -480,10 +491,16 @@ class TestModuleFunctionsLeaks(TestMemLeak):
     def test_cpu_times(self):
         self.execute(psutil.cpu_times)
 
-    @skip_if_linux()
     def test_per_cpu_times(self):
         self.execute(psutil.cpu_times, percpu=True)
 
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_per_cpu_percent(self):
+        # /proc/stat is parsed and compared in C
+        sample = psutil._psplatform.per_cpu_times_raw()
+        self.execute(cext.cpu_stat_percent, sample, sample)
+        self.execute(cext.cpu_stat_times_percent, sample, sample)
+
     def test_cpu_stats(self):
         self.execute(psutil.cpu_stats)
 
@@ -492,6 +509,25 @@ class TestModuleFunctionsLeaks(TestMemLeak):
     def test_cpu_freq(self):
         self.execute(psutil.cpu_freq)
 
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_sysfs_read(self):
+        # cpufreq and hwmon files are kept open and re-read in C
+        safe_rmpath(TESTFN)
+        with open(TESTFN, 'w') as f:
+            f.write("1000\n")
+        self.addCleanup(safe_rmpath, TESTFN)
+        fds = cext.sysfs_open((TESTFN, TESTFN + "-nosuchfile"))
+        try:
+            self.assertEqual(cext.sysfs_read(fds), [1000, None])
+            self.execute(cext.sysfs_read, fds)
+        finally:
+            os.close(fds[0])
+
+    @skip_if_linux()
+    @unittest.skipIf(not HAS_CPU_TOPOLOGY, "not supported")
+    def test_cpu_topology(self):
+        self.execute(psutil.cpu_topology)
+
     # --- mem
 
     def test_virtual_memory(self):
@@ -530,6 +566,102 @@ class TestModuleFunctionsLeaks(TestMemLeak):
     def test_pids(self):
         self.execute(psutil.pids)
 
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_proc_stat_scan(self):
+        self.execute(cext.proc_stat_scan, psutil.PROCFS_PATH)
+
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_proc_counters_scan(self):
+        self.execute(cext.proc_counters_scan, psutil.PROCFS_PATH)
+
+    def test_pids_changes(self):
+        self.execute(psutil.pids_changes)
+
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_proc_pidfd_open(self):
+        def call():
+            try:
+                os.close(cext.proc_pidfd_open(os.getpid()))
+            except OSError:
+                pass
+
+        self.execute(call)
+
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_proc_pidfd_send_signal(self):
+        try:
+            fd = cext.proc_pidfd_open(os.getpid())
+        except OSError as err:
+            raise unittest.SkipTest(str(err))
+        try:
+            self.execute(cext.proc_pidfd_send_signal, fd, 0)
+        finally:
+            os.close(fd)
+
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_proc_watch_open(self):
+        def call():
+            dirfd, fds = cext.proc_watch_open(
+                "/proc/%s" % os.getpid(), ("stat", "status"))
+            for fd in fds + [dirfd]:
+                os.close(fd)
+
+        self.execute(call)
+
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_proc_pread(self):
+        fd = os.open("/proc/%s/status" % os.getpid(), os.O_RDONLY)
+        try:
+            self.execute(cext.proc_pread, fd)
+        finally:
+            os.close(fd)
+
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_proc_smaps_totals(self):
+        self.execute(cext.proc_smaps_totals, "/proc/%s/smaps" % os.getpid())
+
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_proc_events_read(self):
+        try:
+            fd = cext.proc_events_open()
+        except OSError as err:
+            raise unittest.SkipTest("proc connector not available: %s" % err)
+        try:
+            self.execute(cext.proc_events_read, fd)
+        finally:
+            os.close(fd)
+
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_proc_socket_inodes(self):
+        with create_sockets():
+            self.execute(cext.proc_socket_inodes, "/proc")
+            self.execute(cext.proc_socket_inodes, "/proc", [1, 2, 3])
+
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_net_unix_diag(self):
+        try:
+            cext.net_unix_diag()
+        except OSError as err:
+            raise unittest.SkipTest("sock_diag not available: %s" % err)
+        with create_sockets():
+            self.execute(cext.net_unix_diag)
+
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_net_inet_diag(self):
+        try:
+            cext.net_inet_diag(socket.AF_INET, socket.IPPROTO_TCP)
+        except OSError as err:
+            raise unittest.SkipTest("sock_diag not available: %s" % err)
+        flt = psutil._common.ConnFilter(lport=(1, 65535), laddr="0.0.0.0/0")
+        bytecode = psutil._pslinux.Connections.inet_diag_bytecode(flt)
+        with create_sockets():
+            self.execute(cext.net_inet_diag, socket.AF_INET,
+                         socket.IPPROTO_TCP)
+            self.execute(cext.net_inet_diag, socket.AF_INET,
+                         socket.IPPROTO_TCP, 1 << 10, bytecode)
+            self.execute(cext.net_inet_diag, socket.AF_INET,
+                         socket.IPPROTO_TCP, 0xffffffff, b"", True)
+
     # --- net
 
     @unittest.skipIf(TRAVIS and MACOS, "false positive on travis")
@@ -550,10 +682,40 @@ class TestModuleFunctionsLeaks(TestMemLeak):
         self.execute(psutil.net_if_addrs,
                      tolerance_=80 * 1024 if WINDOWS else None)
 
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_net_io_counters_netns(self):
+        # passing a namespace fd creates the netlink socket in a thread
+        fd = os.open("/proc/self/ns/net", os.O_RDONLY)
+        self.addCleanup(os.close, fd)
+        try:
+            cext.net_io_counters(fd)
+        except OSError as err:
+            raise unittest.SkipTest("can't enter netns: %s" % err)
+        self.execute(cext.net_io_counters, fd)
+
+    @unittest.skipIf(not LINUX, "LINUX only")
+    def test_net_if_addrs_filters(self):
+        try:
+            cext.net_if_addrs()
+        except OSError as err:
+            raise unittest.SkipTest("NETLINK_ROUTE not available: %s" % err)
+        self.execute(cext.net_if_addrs, frozenset(['lo', '?!?']),
+                     frozenset([socket.AF_INET, socket.AF_INET6]))
+
     @unittest.skipIf(TRAVIS, "EPERM on travis")
     def test_net_if_stats(self):
         self.execute(psutil.net_if_stats)
 
+    @skip_if_linux()
+    @unittest.skipIf(not HAS_NET_PROTO_COUNTERS, 'not supported')
+    def test_net_proto_counters(self):
+        self.execute(psutil.net_proto_counters, nowrap=False)
+
+    @skip_if_linux()
+    @unittest.skipIf(not HAS_NET_SOFTNET_STATS, 'not supported')
+    def test_net_softnet_stats(self):
+        self.execute(psutil.net_softnet_stats)
+
     # --- sensors
 
     @skip_if_linux()
@@ -75,6 +75,8 @@ class TestSystemAPIs(unittest.TestCase):
         p.wait()
         self.assertNotIn(sproc.pid, [x.pid for x in psutil.process_iter()])
 
+        # Cached instances don't go through Process() again.
+        psutil._pmap.clear()
         with mock.patch('psutil.Process',
                         side_effect=psutil.NoSuchProcess(os.getpid())):
             self.assertEqual(list(psutil.process_iter()), [])
@@ -103,6 +105,142 @@ class TestSystemAPIs(unittest.TestCase):
                 self.assertGreaterEqual(p.info['pid'], 0)
             assert m.called
 
+    def test_pids_changes(self):
+        token, started, exited = psutil.pids_changes()
+        self.assertIsNone(exited)
+        self.assertEqual(started, set(psutil.pids()))
+        sproc = get_test_subprocess()
+        token, started, exited = psutil.pids_changes(token)
+        self.assertIn(sproc.pid, started)
+        self.assertNotIn(sproc.pid, exited)
+        self.assertIn(sproc.pid, [x.pid for x in psutil.process_iter()])
+        p = psutil.Process(sproc.pid)
+        p.kill()
+        p.wait()
+        token, started, exited = psutil.pids_changes(token)
+        self.assertIn(sproc.pid, exited)
+        self.assertNotIn(sproc.pid, started)
+        self.assertNotIn(sproc.pid, [x.pid for x in psutil.process_iter()])
+        token, started, exited = psutil.pids_changes(token)
+        self.assertEqual(started, set())
+        self.assertEqual(exited, set())
+
+    def test_pids_changes_no_events(self):
+        # PIDs are listed and compared with the previous listing.
+        with mock.patch("psutil._psplatform.pids_tracker", create=True,
+                        return_value=None):
+            self.test_pids_changes()
+            psutil._pids_snapshots.clear()
+            # one snapshot per token not used yet
+            token1 = psutil.pids_changes().token
+            token2 = psutil.pids_changes().token
+            for x in range(5):
+                token1 = psutil.pids_changes(token1).token
+                self.assertEqual(len(psutil._pids_snapshots), 2)
+            self.assertEqual(sorted(psutil._pids_snapshots),
+                             sorted([token1, token2]))
+            # a used token
+            token = psutil.pids_changes(token1).token
+            self.assertIsNone(psutil.pids_changes(token1).exited)
+            # unknown token
+            self.assertIsNone(psutil.pids_changes(object()).exited)
+            # dropped tokens
+            for x in range(psutil._PIDS_SNAPSHOTS_MAX):
+                psutil.pids_changes()
+            self.assertEqual(len(psutil._pids_snapshots),
+                             psutil._PIDS_SNAPSHOTS_MAX)
+            self.assertIsNone(psutil.pids_changes(token).exited)
+
+    def test_process_table(self):
+        sproc = get_test_subprocess()
+        t = psutil.process_table(['ppid', 'create_time', 'memory_info'],
+                                 pids=[os.getpid(), sproc.pid])
+        self.assertEqual(
+            sorted(t.keys()),
+            sorted(['pid', 'ppid', 'create_time'] +
+                   ['memory_info.' + x for x in
+                    psutil.Process().memory_info()._fields]))
+        for column in t.values():
+            self.assertEqual(len(column), 2)
+            # buffer protocol
+            self.assertEqual(len(memoryview(column)), 2)
+        self.assertEqual(list(t['pid']), [os.getpid(), sproc.pid])
+        self.assertEqual(t['ppid'][1], os.getpid())
+        self.assertEqual(t['create_time'][1],
+                         psutil.Process(sproc.pid).create_time())
+        self.assertGreater(t['memory_info.rss'][0], 0)
+        self.assertGreater(t['memory_info.vms'][0], 0)
+
+        # all processes
+        t = psutil.process_table(['ppid'])
+        self.assertIn(os.getpid(), t['pid'])
+        self.assertEqual(len(t['pid']), len(t['ppid']))
+        # gone processes are skipped
+        p = psutil.Process(sproc.pid)
+        p.kill()
+        p.wait()
+        t = psutil.process_table(['ppid'], pids=[sproc.pid, os.getpid()])
+        self.assertEqual(list(t['pid']), [os.getpid()])
+
+    def test_process_table_ad(self):
+        # The first call is used to determine the columns.
+        side_effect = [psutil.Process().cpu_times(),
+                       psutil.AccessDenied(0, "")]
+        with mock.patch("psutil._psplatform.Process.cpu_times",
+                        side_effect=side_effect) as m:
+            t = psutil.process_table(['cpu_times'], pids=[os.getpid()])
+            self.assertEqual(m.call_count, 2)
+        self.assertEqual(len(t['pid']), 1)
+        for name in psutil.Process().cpu_times()._fields:
+            value = t['cpu_times.' + name][0]
+            self.assertNotEqual(value, value)  # NaN
+
+    def test_process_table_invalid_attrs(self):
+        self.assertRaises(TypeError, psutil.process_table, 'ppid')
+        self.assertRaises(ValueError, psutil.process_table, ['foo'])
+        self.assertRaises(ValueError, psutil.process_table, ['name'])
+
+    def test_process_monitor(self):
+        mon = psutil.ProcessMonitor()
+        self.assertIsNone(mon.interval)
+        rates = mon.sample()
+        self.assertIn(os.getpid(), rates)
+        for pid, r in rates.items():
+            for value in r:
+                self.assertIn(value, (0.0, None))
+        sproc = get_test_subprocess()
+        # burn some CPU
+        t = time.time()
+        while time.time() - t < 0.1:
+            pass
+        rates = mon.sample()
+        self.assertGreater(mon.interval, 0)
+        self.assertGreater(rates[os.getpid()].cpu_percent, 0)
+        # new process: rates are 0.0 (same as first cpu_percent() call)
+        self.assertEqual(rates[sproc.pid].cpu_percent, 0.0)
+        for r in rates.values():
+            self.assertIsInstance(r, psutil._common.prates)
+            for value in r:
+                if value is not None:
+                    self.assertGreaterEqual(value, 0)
+        # gone processes
+        p = psutil.Process(sproc.pid)
+        p.kill()
+        p.wait()
+        self.assertNotIn(sproc.pid, mon.sample())
+
+    def test_process_monitor_pid_reused(self):
+        mon = psutil.ProcessMonitor()
+        mon.sample()
+        counters = psutil._proc_counters_map()
+        old = list(counters[os.getpid()])
+        old[0] = -1  # different start time
+        old[1] = 0.0
+        counters[os.getpid()] = tuple(old)
+        mon._last_counters = counters
+        rates = mon.sample()
+        self.assertEqual(rates[os.getpid()].cpu_percent, 0.0)
+
     def test_wait_procs(self):
         def callback(p):
             pids.append(p.pid)
@@ -637,6 +775,22 @@ class TestSystemAPIs(unittest.TestCase):
         elif WINDOWS:
             self.assertEqual(psutil.AF_LINK, -1)
 
+    def test_net_if_addrs_filters(self):
+        nics = psutil.net_if_addrs()
+        name = sorted(nics.keys())[0]
+        self.assertEqual(psutil.net_if_addrs(nics=[name, "?!?"]),
+                         {name: nics[name]})
+        self.assertEqual(psutil.net_if_addrs(nics=name), {name: nics[name]})
+        self.assertEqual(psutil.net_if_addrs(nics=[]), {})
+        family = nics[name][0].family
+        ret = psutil.net_if_addrs(families=[family])
+        assert ret, ret
+        for addrs in ret.values():
+            for addr in addrs:
+                self.assertEqual(addr.family, family)
+        self.assertEqual(psutil.net_if_addrs(families=family), ret)
+        self.assertEqual(psutil.net_if_addrs(families=[]), {})
+
     def test_net_if_addrs_mac_null_bytes(self):
         # Simulate that the underlying C function returns an incomplete
         # MAC address. psutil is supposed to fill it with null bytes.
@@ -674,12 +828,26 @@ class TestSystemAPIs(unittest.TestCase):
                      "LINUX or BSD or MACOS specific")
     def test_net_if_stats_enodev(self):
         # See: https://github.com/giampaolo/psutil/issues/1279
+        if LINUX:
+            # force the per-NIC ioctl() fallback
+            patch = mock.patch('psutil._psplatform.cext.net_if_stats',
+                               side_effect=OSError)
+            patch.start()
+            self.addCleanup(patch.stop)
         with mock.patch('psutil._psutil_posix.net_if_mtu',
                         side_effect=OSError(errno.ENODEV, "")) as m:
             ret = psutil.net_if_stats()
             self.assertEqual(ret, {})
             assert m.called
 
+    def test_net_if_stats_nics(self):
+        nics = psutil.net_if_stats()
+        name = sorted(nics.keys())[0]
+        self.assertEqual(psutil.net_if_stats([name, "?!?"]),
+                         {name: nics[name]})
+        self.assertEqual(psutil.net_if_stats(name), {name: nics[name]})
+        self.assertEqual(psutil.net_if_stats([]), {})
+
     @unittest.skipIf(LINUX and not os.path.exists('/proc/diskstats'),
                      '/proc/diskstats not available on this linux version')
     @unittest.skipIf(APPVEYOR and psutil.disk_io_counters() is None,
@@ -39,12 +39,17 @@ if psutil.LINUX:
     names += [
         # 'memory_full_info',
         # 'memory_maps',
+        'cmdline',
+        'connections',
         'cpu_num',
         'cpu_times',
         'gids',
+        'io_counters',
         'name',
         'num_ctx_switches',
+        'num_fds',
         'num_threads',
+        'open_files',
         'ppid',
         'status',
         'terminal',
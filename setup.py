@@ -226,7 +226,16 @@ elif LINUX:
         macros.append(ETHTOOL_MACRO)
     ext = Extension(
         'psutil._psutil_linux',
-        sources=sources + ['psutil/_psutil_linux.c'],
+        sources=sources + [
+            'psutil/_psutil_linux.c',
+            'psutil/arch/linux/cpu.c',
+            'psutil/arch/linux/netlink.c',
+            'psutil/arch/linux/proc.c',
+            'psutil/arch/linux/proc_events.c',
+            'psutil/arch/linux/rtnetlink.c',
+            'psutil/arch/linux/sock_diag.c',
+            'psutil/arch/linux/sysfs.c',
+        ],
         define_macros=macros)
 
 elif SUNOS: